@@ -1,5 +1,7 @@
 #include "array.h"
 #include "value.h"
+#include "string.h"
+#include "bigint.h"
 #include "exceptions.h"
 
 
@@ -38,9 +40,50 @@ Value Array::pop(const Location &location) {
   return last_val;
 }
 
+Value *Array::at(int index, const Location &location) {
+  if (index >= 0 && index < m_size) {
+    return &m_array[index];
+  }
+  EvaluationError::raise(location, "Array index out of bound: %d\n", index);
+}
+
 Value Array::get(int index, const Location &location) const {
   if (index >= 0 && index < m_size) {
     return m_array[index];
   }
   EvaluationError::raise(location, "Array index out of bound: %d\n", index);
 }
+
+
+void Array::sort(const Location &location) {
+  bool all_ints = true, all_numeric = true, all_strings = true;
+  for (auto i = m_array.begin(); i != m_array.end(); ++i) {
+    all_ints = all_ints && i->get_kind() == VALUE_INT;
+    all_numeric = all_numeric && i->is_numeric();
+    all_strings = all_strings && i->get_kind() == VALUE_STRING;
+  }
+
+  if (all_ints) {
+    // sort the unboxed ints
+    std::vector<int64_t> ints;
+    ints.reserve(m_size);
+    for (auto i = m_array.begin(); i != m_array.end(); ++i) {
+      ints.push_back(i->get_ival());
+    }
+    sortutil::sort_ints(ints);
+    for (int i = 0; i < m_size; i++) {
+      m_array[i] = Value(ints[i]);
+    }
+  } else if (all_numeric) {
+    // some of the numbers are bigints or doubles
+    sortutil::merge_sort(m_array, [](const Value &a, const Value &b) {
+      return a.compare_numeric(b) < 0;
+    });
+  } else if (all_strings) {
+    sortutil::merge_sort(m_array, [](const Value &a, const Value &b) {
+      return a.get_string()->compare(b.get_string()) < 0;
+    });
+  } else {
+    EvaluationError::raise(location, "Only arrays of numbers or of strings can be sorted");
+  }
+}
\ No newline at end of file
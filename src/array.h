@@ -4,6 +4,7 @@
 #include <vector>
 #include "valrep.h"
 #include "value.h"
+#include "sort.h"
 
 class Value;
 
@@ -20,8 +21,22 @@ public:
   int len() const {return m_size;};
   Value get(int index, const Location &location) const;
   Value set(int index, const Value& val, const Location &location);
+  // pointer to an element, valid until the array is resized
+  Value *at(int index, const Location &location);
   Value push(const Value& val);
   Value pop(const Location &location);
 
+  // Sort in place: ints in ascending order, or strings byte-wise
+  void sort(const Location &location);
+
+  // Stable sort in place, where less(a, b) is true if a should come
+  // before b.  If less throws, the array is left unchanged.
+  template<typename Less>
+  void sort_by(Less less) {
+    std::vector<Value> sorted(m_array);
+    sortutil::merge_sort(sorted, less);
+    m_array.swap(sorted);
+  }
+
 };
 #endif //ARRAY_H
@@ -63,6 +63,58 @@ std::string ASTTreePrint::node_tag_to_string(int tag) const {
     return "PARAMETER_LIST";
   case AST_STRING_LITERAL:
     return "STRING_LITERAL";
+  case AST_RECORD:
+    return "RECORD";
+  case AST_FIELDREF:
+    return "FIELDREF";
+  case AST_FIELD_ASSIGN:
+    return "FIELD_ASSIGN";
+  case AST_INDEX:
+    return "INDEX";
+  case AST_INDEX_ASSIGN:
+    return "INDEX_ASSIGN";
+  case AST_ADD_ASSIGN:
+    return "ADD_ASSIGN";
+  case AST_SUB_ASSIGN:
+    return "SUB_ASSIGN";
+  case AST_MULTIPLY_ASSIGN:
+    return "MULTIPLY_ASSIGN";
+  case AST_DIVIDE_ASSIGN:
+    return "DIVIDE_ASSIGN";
+  case AST_INCREMENT:
+    return "INCREMENT";
+  case AST_DECREMENT:
+    return "DECREMENT";
+  case AST_FOR_RANGE:
+    return "FOR_RANGE";
+  case AST_FOR_EACH:
+    return "FOR_EACH";
+  case AST_BREAK:
+    return "BREAK";
+  case AST_CONTINUE:
+    return "CONTINUE";
+  case AST_RETURN:
+    return "RETURN";
+  case AST_SWITCH:
+    return "SWITCH";
+  case AST_CASE:
+    return "CASE";
+  case AST_DEFAULT:
+    return "DEFAULT";
+  case AST_FLOAT_LITERAL:
+    return "FLOAT_LITERAL";
+  case AST_MODULO:
+    return "MODULO";
+  case AST_BITAND:
+    return "BITAND";
+  case AST_BITOR:
+    return "BITOR";
+  case AST_BITXOR:
+    return "BITXOR";
+  case AST_SHIFT_LEFT:
+    return "SHIFT_LEFT";
+  case AST_SHIFT_RIGHT:
+    return "SHIFT_RIGHT";
   default:
     RuntimeError::raise("Unknown AST node type %d\n", tag);
   }
@@ -33,6 +33,32 @@ enum ASTKind {
   AST_FUNCTION,
   AST_PARAM_LIST,
   AST_STRING_LITERAL,
+  AST_RECORD,         // record
+  AST_FIELDREF,       // .
+  AST_FIELD_ASSIGN,   // . =
+  AST_INDEX,          // [ ]
+  AST_INDEX_ASSIGN,   // [ ] =
+  AST_ADD_ASSIGN,     // +=
+  AST_SUB_ASSIGN,     // -=
+  AST_MULTIPLY_ASSIGN,// *=
+  AST_DIVIDE_ASSIGN,  // /=
+  AST_INCREMENT,      // ++
+  AST_DECREMENT,      // --
+  AST_FOR_RANGE,      // for (i in lo..hi)
+  AST_FOR_EACH,       // for (x in container)
+  AST_BREAK,          // break
+  AST_CONTINUE,       // continue
+  AST_RETURN,         // return
+  AST_SWITCH,         // switch
+  AST_CASE,           // case
+  AST_DEFAULT,        // default
+  AST_FLOAT_LITERAL,
+  AST_MODULO,         // %
+  AST_BITAND,         // &
+  AST_BITOR,          // |
+  AST_BITXOR,         // ^
+  AST_SHIFT_LEFT,     // <<
+  AST_SHIFT_RIGHT,    // >>
 };
 
 class ASTTreePrint : public TreePrint {
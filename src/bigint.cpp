@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <cmath>
+#include "bigint.h"
+#include "value.h"
+
+namespace {
+
+typedef std::vector<uint32_t> Mag;
+
+struct Num {
+  bool negative;
+  Mag mag;
+};
+
+void trim(Mag &mag) {
+  while (!mag.empty() && mag.back() == 0) {
+    mag.pop_back();
+  }
+}
+
+Num to_num(const Value &val) {
+  if (val.get_kind() == VALUE_BIGINT) {
+    BigInt *big = val.get_bigint();
+    return { big->is_negative(), big->get_mag() };
+  }
+  int64_t ival = val.get_ival();
+  // unsigned negation also works for INT64_MIN
+  uint64_t m = ival < 0 ? 0 - uint64_t(ival) : uint64_t(ival);
+  Num num = { ival < 0, { uint32_t(m), uint32_t(m >> 32) } };
+  trim(num.mag);
+  return num;
+}
+
+// The value of a number: an int if it fits in 64 bits, otherwise a BigInt
+Value to_value(bool negative, Mag &mag) {
+  trim(mag);
+  if (mag.size() <= 2) {
+    uint64_t m = mag.empty() ? 0 : mag[0];
+    if (mag.size() == 2) {
+      m |= uint64_t(mag[1]) << 32;
+    }
+    if (!negative && m <= uint64_t(INT64_MAX)) {
+      return Value(int64_t(m));
+    }
+    if (negative && m <= uint64_t(INT64_MAX) + 1) {
+      return Value(int64_t(0 - m));
+    }
+  }
+  return Value(new BigInt(negative, mag));
+}
+
+int compare_mag(const Mag &a, const Mag &b) {
+  if (a.size() != b.size()) {
+    return a.size() < b.size() ? -1 : 1;
+  }
+  for (size_t i = a.size(); i-- > 0; ) {
+    if (a[i] != b[i]) {
+      return a[i] < b[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+Mag add_mag(const Mag &a, const Mag &b) {
+  const Mag &longer = a.size() >= b.size() ? a : b;
+  const Mag &shorter = a.size() >= b.size() ? b : a;
+  Mag sum(longer.size() + 1);
+  uint64_t carry = 0;
+  for (size_t i = 0; i < longer.size(); i++) {
+    uint64_t t = uint64_t(longer[i]) + (i < shorter.size() ? shorter[i] : 0) + carry;
+    sum[i] = uint32_t(t);
+    carry = t >> 32;
+  }
+  sum[longer.size()] = uint32_t(carry);
+  trim(sum);
+  return sum;
+}
+
+// a - b, where a >= b
+Mag sub_mag(const Mag &a, const Mag &b) {
+  Mag diff(a.size());
+  int64_t borrow = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    int64_t t = int64_t(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+    diff[i] = uint32_t(t);
+    borrow = t < 0 ? 1 : 0;
+  }
+  trim(diff);
+  return diff;
+}
+
+Mag mul_mag(const Mag &a, const Mag &b) {
+  if (a.empty() || b.empty()) {
+    return Mag();
+  }
+  Mag prod(a.size() + b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    uint64_t carry = 0;
+    for (size_t j = 0; j < b.size(); j++) {
+      uint64_t t = uint64_t(a[i]) * b[j] + prod[i + j] + carry;
+      prod[i + j] = uint32_t(t);
+      carry = t >> 32;
+    }
+    prod[i + b.size()] = uint32_t(carry);
+  }
+  trim(prod);
+  return prod;
+}
+
+// Divide a by a single limb, returning the remainder
+uint32_t divmod_limb(const Mag &a, uint32_t d, Mag &quot) {
+  quot.assign(a.size(), 0);
+  uint64_t rem = 0;
+  for (size_t i = a.size(); i-- > 0; ) {
+    uint64_t cur = (rem << 32) | a[i];
+    quot[i] = uint32_t(cur / d);
+    rem = cur % d;
+  }
+  trim(quot);
+  return uint32_t(rem);
+}
+
+// Long division of a by b (which is nonzero), Knuth's algorithm D
+void divmod_mag(const Mag &a, const Mag &b, Mag &quot, Mag &rem) {
+  if (compare_mag(a, b) < 0) {
+    quot.clear();
+    rem = a;
+    return;
+  }
+  if (b.size() == 1) {
+    uint32_t r = divmod_limb(a, b[0], quot);
+    rem.assign(1, r);
+    trim(rem);
+    return;
+  }
+
+  // normalize, so that the divisor's top limb has its high bit set
+  int shift = __builtin_clz(b.back());
+  size_t n = b.size(), m = a.size() - n;
+  Mag un(a.size() + 1), vn(n);
+  for (size_t i = n; i-- > 0; ) {
+    vn[i] = (b[i] << shift) | (shift && i > 0 ? b[i - 1] >> (32 - shift) : 0);
+  }
+  un[a.size()] = shift ? a.back() >> (32 - shift) : 0;
+  for (size_t i = a.size(); i-- > 0; ) {
+    un[i] = (a[i] << shift) | (shift && i > 0 ? a[i - 1] >> (32 - shift) : 0);
+  }
+
+  const uint64_t BASE = uint64_t(1) << 32;
+  quot.assign(m + 1, 0);
+  for (size_t j = m + 1; j-- > 0; ) {
+    // estimate the quotient limb from the top two limbs
+    uint64_t num = (uint64_t(un[j + n]) << 32) | un[j + n - 1];
+    uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+    while (qhat >= BASE || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      qhat--;
+      rhat += vn[n - 1];
+      if (rhat >= BASE) {
+        break;
+      }
+    }
+
+    // multiply and subtract
+    int64_t borrow = 0;
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+      uint64_t p = qhat * vn[i] + carry;
+      carry = p >> 32;
+      int64_t t = int64_t(un[i + j]) - borrow - int64_t(p & 0xffffffffU);
+      un[i + j] = uint32_t(t);
+      borrow = t < 0 ? 1 : 0;
+    }
+    int64_t t = int64_t(un[j + n]) - borrow - int64_t(carry);
+    un[j + n] = uint32_t(t);
+
+    // the estimate was one too large: add the divisor back
+    if (t < 0) {
+      qhat--;
+      uint64_t c = 0;
+      for (size_t i = 0; i < n; i++) {
+        uint64_t s = uint64_t(un[i + j]) + vn[i] + c;
+        un[i + j] = uint32_t(s);
+        c = s >> 32;
+      }
+      un[j + n] += uint32_t(c);
+    }
+    quot[j] = uint32_t(qhat);
+  }
+  trim(quot);
+
+  // unnormalize the remainder
+  rem.assign(n, 0);
+  for (size_t i = 0; i < n; i++) {
+    rem[i] = (un[i] >> shift) | (shift ? un[i + 1] << (32 - shift) : 0);
+  }
+  trim(rem);
+}
+
+Value add_nums(const Num &a, const Num &b) {
+  Mag mag;
+  bool negative;
+  if (a.negative == b.negative) {
+    mag = add_mag(a.mag, b.mag);
+    negative = a.negative;
+  } else if (compare_mag(a.mag, b.mag) >= 0) {
+    mag = sub_mag(a.mag, b.mag);
+    negative = a.negative;
+  } else {
+    mag = sub_mag(b.mag, a.mag);
+    negative = b.negative;
+  }
+  return to_value(negative, mag);
+}
+
+// The low size limbs of a number in two's complement
+Mag to_twos(const Num &num, size_t size) {
+  Mag bits(num.mag);
+  bits.resize(size, 0);
+  if (num.negative) {
+    // invert and add one
+    uint64_t carry = 1;
+    for (size_t i = 0; i < size; i++) {
+      uint64_t t = uint64_t(uint32_t(~bits[i])) + carry;
+      bits[i] = uint32_t(t);
+      carry = t >> 32;
+    }
+  }
+  return bits;
+}
+
+// The value of a two's complement number, whose top bit is the sign
+Value from_twos(Mag &bits) {
+  bool negative = !bits.empty() && (bits.back() >> 31) != 0;
+  if (negative) {
+    Mag one(1, 1);
+    for (size_t i = 0; i < bits.size(); i++) {
+      bits[i] = ~bits[i];
+    }
+    trim(bits);
+    bits = add_mag(bits, one);
+  }
+  return to_value(negative, bits);
+}
+
+template<typename Op>
+Value bitwise(const Value &a, const Value &b, Op op) {
+  Num na = to_num(a), nb = to_num(b);
+  // one spare limb, so the sign bit of the result is right
+  size_t size = std::max(na.mag.size(), nb.mag.size()) + 1;
+  Mag ta = to_twos(na, size), tb = to_twos(nb, size);
+  for (size_t i = 0; i < size; i++) {
+    ta[i] = op(ta[i], tb[i]);
+  }
+  return from_twos(ta);
+}
+
+Mag shift_left_mag(const Mag &mag, int64_t n) {
+  if (mag.empty()) {
+    return Mag();
+  }
+  size_t limbs = size_t(n / 32);
+  int bits = int(n % 32);
+  Mag res(limbs + mag.size() + 1, 0);
+  for (size_t i = 0; i < mag.size(); i++) {
+    res[limbs + i] |= mag[i] << bits;
+    res[limbs + i + 1] = bits ? mag[i] >> (32 - bits) : 0;
+  }
+  trim(res);
+  return res;
+}
+
+Mag shift_right_mag(const Mag &mag, int64_t n) {
+  size_t limbs = size_t(n / 32);
+  if (limbs >= mag.size()) {
+    return Mag();
+  }
+  int bits = int(n % 32);
+  Mag res(mag.size() - limbs);
+  for (size_t i = 0; i < res.size(); i++) {
+    uint32_t hi = bits && limbs + i + 1 < mag.size() ? mag[limbs + i + 1] << (32 - bits) : 0;
+    res[i] = (mag[limbs + i] >> bits) | hi;
+  }
+  trim(res);
+  return res;
+}
+
+}
+
+BigInt::BigInt(bool negative, const std::vector<uint32_t> &mag)
+  : ValRep(VALREP_BIGINT)
+  , m_negative(negative)
+  , m_mag(mag) {
+}
+
+BigInt::~BigInt() {
+}
+
+std::string BigInt::as_str() const {
+  // peel off groups of 9 decimal digits, least significant first
+  std::vector<uint32_t> groups;
+  Mag mag(m_mag), quot;
+  while (!mag.empty()) {
+    groups.push_back(divmod_limb(mag, 1000000000U, quot));
+    mag.swap(quot);
+  }
+  std::string str = m_negative ? "-" : "";
+  str += std::to_string(groups.back());
+  for (size_t i = groups.size() - 1; i-- > 0; ) {
+    std::string group = std::to_string(groups[i]);
+    str.append(9 - group.size(), '0');
+    str += group;
+  }
+  return str;
+}
+
+double BigInt::to_double() const {
+  double dval = 0;
+  for (size_t i = m_mag.size(); i-- > 0; ) {
+    dval = dval * 4294967296.0 + m_mag[i];
+  }
+  return m_negative ? -dval : dval;
+}
+
+Value BigInt::add(const Value &a, const Value &b) {
+  return add_nums(to_num(a), to_num(b));
+}
+
+Value BigInt::sub(const Value &a, const Value &b) {
+  Num nb = to_num(b);
+  nb.negative = !nb.negative;
+  return add_nums(to_num(a), nb);
+}
+
+Value BigInt::mul(const Value &a, const Value &b) {
+  Num na = to_num(a), nb = to_num(b);
+  Mag mag = mul_mag(na.mag, nb.mag);
+  return to_value(na.negative != nb.negative, mag);
+}
+
+Value BigInt::div(const Value &a, const Value &b) {
+  Num na = to_num(a), nb = to_num(b);
+  Mag quot, rem;
+  divmod_mag(na.mag, nb.mag, quot, rem);
+  return to_value(na.negative != nb.negative, quot);
+}
+
+Value BigInt::rem(const Value &a, const Value &b) {
+  Num na = to_num(a), nb = to_num(b);
+  Mag quot, rem;
+  divmod_mag(na.mag, nb.mag, quot, rem);
+  return to_value(na.negative, rem);
+}
+
+Value BigInt::bit_and(const Value &a, const Value &b) {
+  return bitwise(a, b, [](uint32_t x, uint32_t y) { return x & y; });
+}
+
+Value BigInt::bit_or(const Value &a, const Value &b) {
+  return bitwise(a, b, [](uint32_t x, uint32_t y) { return x | y; });
+}
+
+Value BigInt::bit_xor(const Value &a, const Value &b) {
+  return bitwise(a, b, [](uint32_t x, uint32_t y) { return x ^ y; });
+}
+
+Value BigInt::shift_left(const Value &a, int64_t n) {
+  Num na = to_num(a);
+  Mag mag = shift_left_mag(na.mag, n);
+  return to_value(na.negative, mag);
+}
+
+Value BigInt::shift_right(const Value &a, int64_t n) {
+  Num na = to_num(a);
+  if (!na.negative) {
+    Mag mag = shift_right_mag(na.mag, n);
+    return to_value(false, mag);
+  }
+  // floor(a / 2^n) is -((|a| - 1) / 2^n) - 1
+  Mag one(1, 1);
+  Mag mag = add_mag(shift_right_mag(sub_mag(na.mag, one), n), one);
+  return to_value(true, mag);
+}
+
+int BigInt::compare(const Value &a, const Value &b) {
+  Num na = to_num(a), nb = to_num(b);
+  if (na.negative != nb.negative) {
+    return na.negative ? -1 : 1;
+  }
+  int cmp = compare_mag(na.mag, nb.mag);
+  return na.negative ? -cmp : cmp;
+}
+
+Value BigInt::parse(const std::string &digits) {
+  Mag mag;
+  for (size_t i = 0; i < digits.size(); ) {
+    // multiply in up to 9 digits at a time
+    size_t len = std::min(digits.size() - i, size_t(9));
+    uint32_t scale = 1, group = 0;
+    for (size_t k = 0; k < len; k++) {
+      scale *= 10;
+      group = group * 10 + uint32_t(digits[i + k] - '0');
+    }
+    mag = add_mag(mul_mag(mag, Mag(1, scale)), Mag(1, group));
+    i += len;
+  }
+  return to_value(false, mag);
+}
+
+Value BigInt::from_double(double dval) {
+  // dval is mant * 2^exp, with a 53-bit integer mant
+  int exp;
+  double frac = std::frexp(std::fabs(dval), &exp);
+  uint64_t mant = uint64_t(std::ldexp(frac, 53));
+  exp -= 53;
+  if (exp < 0) {
+    mant >>= -exp;
+    exp = 0;
+  }
+
+  // shift the mantissa left by exp bits
+  Mag mag(exp / 32, 0);
+  int bits = exp % 32;
+  mag.push_back(uint32_t(mant << bits));
+  mag.push_back(uint32_t(mant >> (32 - bits)));
+  mag.push_back(bits ? uint32_t(mant >> (64 - bits)) : 0);
+  return to_value(dval < 0, mag);
+}
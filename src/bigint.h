@@ -0,0 +1,62 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+
+// An arbitrary-precision integer, used only for values that don't fit
+// in 64 bits: arithmetic on ints promotes to a BigInt on overflow, and
+// a result that fits in 64 bits is always an int again.  So a BigInt
+// is never zero, and never equal to an int.
+//
+// The magnitude is stored as 32-bit limbs, least significant first,
+// with no leading zero limbs.
+class BigInt : public ValRep {
+private:
+  bool m_negative;
+  std::vector<uint32_t> m_mag;
+
+public:
+  BigInt(bool negative, const std::vector<uint32_t> &mag);
+  virtual ~BigInt();
+
+  bool is_negative() const { return m_negative; }
+  const std::vector<uint32_t> &get_mag() const { return m_mag; }
+
+  std::string as_str() const;
+  double to_double() const;
+
+  // Arithmetic on ints and BigInts (either argument may be either kind).
+  // div truncates toward zero, and rem has the sign of the dividend;
+  // the caller must check that the divisor isn't zero.
+  static Value add(const Value &a, const Value &b);
+  static Value sub(const Value &a, const Value &b);
+  static Value mul(const Value &a, const Value &b);
+  static Value div(const Value &a, const Value &b);
+  static Value rem(const Value &a, const Value &b);
+
+  // Bitwise operations, as if on infinitely sign-extended two's
+  // complement.  shift_right rounds toward negative infinity; the shift
+  // count must not be negative.
+  static Value bit_and(const Value &a, const Value &b);
+  static Value bit_or(const Value &a, const Value &b);
+  static Value bit_xor(const Value &a, const Value &b);
+  static Value shift_left(const Value &a, int64_t n);
+  static Value shift_right(const Value &a, int64_t n);
+
+  // negative, zero or positive as a is less than, equal to or greater than b
+  static int compare(const Value &a, const Value &b);
+
+  // value of a string of decimal digits
+  static Value parse(const std::string &digits);
+
+  // value of a finite double with no fractional part
+  static Value from_double(double dval);
+};
+
+#endif //BIGINT_H
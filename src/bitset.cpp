@@ -0,0 +1,109 @@
+#include <algorithm>
+#include "bitset.h"
+#include "exceptions.h"
+
+// The bulk operations are plain loops over 64-bit words.  On x86-64,
+// GCC compiles extra versions of them using POPCNT and AVX2, and picks
+// the best one supported by the CPU when the program starts.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#  define BITSET_POPCNT_CLONES __attribute__((target_clones("popcnt", "default")))
+#  define BITSET_AVX2_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#  define BITSET_POPCNT_CLONES
+#  define BITSET_AVX2_CLONES
+#endif
+
+namespace {
+
+BITSET_POPCNT_CLONES
+int popcount_words(const uint64_t *words, size_t n) {
+  int count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += __builtin_popcountll(words[i]);
+  }
+  return count;
+}
+
+BITSET_AVX2_CLONES
+void or_words(uint64_t *dst, const uint64_t *src, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] |= src[i];
+  }
+}
+
+BITSET_AVX2_CLONES
+void and_words(uint64_t *dst, const uint64_t *src, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    dst[i] &= src[i];
+  }
+}
+
+}
+
+Bitset::Bitset(int nbits)
+  : ValRep(VALREP_BITSET)
+  , m_words((size_t(nbits) + 63) / 64)
+  , m_nbits(nbits) {
+}
+
+Bitset::~Bitset() {
+}
+
+void Bitset::set(int index, const Location &location) {
+  if (index < 0) {
+    EvaluationError::raise(location, "Bitset index out of bound: %d", index);
+  }
+  if (index >= m_nbits) {
+    grow(index + 1);
+  }
+  m_words[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+void Bitset::clear(int index, const Location &location) {
+  if (index < 0) {
+    EvaluationError::raise(location, "Bitset index out of bound: %d", index);
+  }
+  if (index < m_nbits) {
+    m_words[index / 64] &= ~(uint64_t(1) << (index % 64));
+  }
+}
+
+bool Bitset::test(int index, const Location &location) const {
+  if (index < 0) {
+    EvaluationError::raise(location, "Bitset index out of bound: %d", index);
+  }
+  if (index >= m_nbits) {
+    return false;
+  }
+  return (m_words[index / 64] >> (index % 64)) & 1;
+}
+
+int Bitset::count() const {
+  return popcount_words(m_words.data(), m_words.size());
+}
+
+void Bitset::unite(const Bitset *other) {
+  if (other->m_nbits > m_nbits) {
+    grow(other->m_nbits);
+  }
+  // the other set's words past its size are zero
+  size_t n = std::min(m_words.size(), other->m_words.size());
+  or_words(m_words.data(), other->m_words.data(), n);
+}
+
+void Bitset::intersect(const Bitset *other) {
+  size_t n = std::min(m_words.size(), other->m_words.size());
+  and_words(m_words.data(), other->m_words.data(), n);
+  // members beyond the end of the other set are not in the intersection
+  std::fill(m_words.begin() + n, m_words.end(), 0);
+}
+
+// Make the set nbits long.  The words grow geometrically, so that
+// adding increasing members is cheap.
+void Bitset::grow(int nbits) {
+  size_t nwords = (size_t(nbits) + 63) / 64;
+  if (nwords > m_words.size()) {
+    m_words.resize(std::max(nwords, 2 * m_words.size()), 0);
+  }
+  m_nbits = nbits;
+}
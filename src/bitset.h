@@ -0,0 +1,54 @@
+#ifndef BITSET_H
+#define BITSET_H
+
+#include <cstdint>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// A dense set of non-negative integers, stored one bit per member.
+// Setting a bit beyond the current size grows the set.
+class Bitset : public ValRep {
+private:
+  // may have room for more than m_nbits bits; the bits past m_nbits
+  // are always zero
+  std::vector<uint64_t> m_words;
+  int m_nbits;
+
+public:
+  Bitset(int nbits);
+  virtual ~Bitset();
+
+  int len() const { return m_nbits; }
+
+  void set(int index, const Location &location);
+  void clear(int index, const Location &location);
+  bool test(int index, const Location &location) const;
+
+  // number of members
+  int count() const;
+
+  // in-place union and intersection with another bitset
+  void unite(const Bitset *other);
+  void intersect(const Bitset *other);
+
+  // invoke a function on each member, in increasing order
+  template<typename Fn>
+  void each_member(Fn fn) const {
+    for (size_t w = 0; w < m_words.size(); w++) {
+      uint64_t word = m_words[w];
+      while (word != 0) {
+        fn(int(w * 64 + __builtin_ctzll(word)));
+        word &= word - 1;
+      }
+    }
+  }
+
+private:
+  void grow(int nbits);
+};
+
+#endif //BITSET_H
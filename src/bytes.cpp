@@ -0,0 +1,48 @@
+#include "bytes.h"
+#include "exceptions.h"
+
+Bytes::Bytes(size_t size)
+  : ValRep(VALREP_BYTES)
+  , m_bytes(size) {
+}
+
+Bytes::Bytes(const char *data, size_t len)
+  : ValRep(VALREP_BYTES)
+  , m_bytes(data, data + len) {
+}
+
+Bytes::~Bytes() {
+}
+
+int Bytes::get(int index, const Location &location) const {
+  if (index >= 0 && index < len()) {
+    return m_bytes[index];
+  }
+  EvaluationError::raise(location, "Bytes index out of bound: %d", index);
+}
+
+int Bytes::set(int index, int val, const Location &location) {
+  if (index < 0 || index >= len()) {
+    EvaluationError::raise(location, "Bytes index out of bound: %d", index);
+  }
+  if (val < 0 || val > 255) {
+    EvaluationError::raise(location, "Byte value out of range: %d", val);
+  }
+  m_bytes[index] = (unsigned char) val;
+  return val;
+}
+
+void Bytes::append_byte(int val, const Location &location) {
+  if (val < 0 || val > 255) {
+    EvaluationError::raise(location, "Byte value out of range: %d", val);
+  }
+  m_bytes.push_back((unsigned char) val);
+}
+
+void Bytes::append(const char *data, size_t len) {
+  m_bytes.insert(m_bytes.end(), data, data + len);
+}
+
+std::string Bytes::get_actual_string() const {
+  return std::string(reinterpret_cast<const char *>(m_bytes.data()), m_bytes.size());
+}
@@ -0,0 +1,34 @@
+#ifndef BYTES_H
+#define BYTES_H
+
+#include <string>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// A mutable, growable buffer of bytes
+class Bytes : public ValRep {
+private:
+  std::vector<unsigned char> m_bytes;
+
+public:
+  Bytes(size_t size = 0);
+  Bytes(const char *data, size_t len);
+  virtual ~Bytes();
+
+  int len() const { return int(m_bytes.size()); }
+  const unsigned char *data() const { return m_bytes.data(); }
+
+  int get(int index, const Location &location) const;
+  int set(int index, int val, const Location &location);
+
+  void append_byte(int val, const Location &location);
+  void append(const char *data, size_t len);
+
+  std::string get_actual_string() const;
+};
+
+#endif //BYTES_H
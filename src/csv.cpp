@@ -0,0 +1,305 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "csv.h"
+#include "array.h"
+#include "string.h"
+#include "bytes.h"
+#include "bigint.h"
+#include "inbuf.h"
+#include "exceptions.h"
+
+namespace {
+
+// Integers with at most this many digits fit in 64 bits
+const size_t MAX_INT64_DIGITS = 18;
+
+// The first sep, quote or newline at or after p, or end.  Most bytes of
+// CSV data are none of these, so they are skipped 16 at a time.
+const char *find_structural(const char *p, const char *end, char sep) {
+#ifdef __SSE2__
+  const __m128i seps = _mm_set1_epi8(sep);
+  const __m128i quotes = _mm_set1_epi8('"');
+  const __m128i newlines = _mm_set1_epi8('\n');
+  while (end - p >= 16) {
+    __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, seps), _mm_cmpeq_epi8(chunk, quotes)),
+                                _mm_cmpeq_epi8(chunk, newlines));
+    int mask = _mm_movemask_epi8(hits);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 16;
+  }
+#endif
+  while (p < end && *p != sep && *p != '"' && *p != '\n') {
+    p++;
+  }
+  return p;
+}
+
+// Splits data into records and fields
+class Parser {
+private:
+  const char *m_pos, *m_end;
+  char m_sep;
+
+  // the end of an unquoted field: quotes inside it are ordinary chars
+  const char *find_field_end(const char *p) const {
+    p = find_structural(p, m_end, m_sep);
+    while (p < m_end && *p == '"') {
+      p = find_structural(p + 1, m_end, m_sep);
+    }
+    return p;
+  }
+
+public:
+  Parser(const char *data, size_t len, char sep)
+    : m_pos(data), m_end(data + len), m_sep(sep) { }
+
+  // For reading records a line at a time: whether the data (a line,
+  // without its newline) ends inside a quoted field, so that the record
+  // continues on the next line.  in_quote means that the data continues
+  // a quoted field from the line before.  Quotes are treated as by
+  // next_record: they open a field only at its start.
+  bool ends_in_quote(bool in_quote) const {
+    const char *p = m_pos;
+    for (;;) {
+      if (in_quote) {
+        const char *quote = static_cast<const char *>(memchr(p, '"', m_end - p));
+        if (quote == nullptr) {
+          return true;
+        }
+        if (quote + 1 < m_end && quote[1] == '"') {
+          p = quote + 2;
+          continue;
+        }
+        in_quote = false;
+        p = find_field_end(quote + 1);
+      } else if (p < m_end && *p == '"') {
+        in_quote = true;
+        p++;
+        continue;
+      } else {
+        p = find_field_end(p);
+      }
+      if (p >= m_end) {
+        return false;
+      }
+      // skip the separator
+      p++;
+    }
+  }
+
+  // Call field(data, len, escaped) for each field of the next record,
+  // where escaped means that the field contains "" escapes.  Returns
+  // false if there are no more records.
+  template<typename Field>
+  bool next_record(Field field) {
+    if (m_pos >= m_end) {
+      return false;
+    }
+    for (;;) {
+      if (*m_pos == '"') {
+        const char *start = ++m_pos;
+        bool escaped = false;
+        for (;;) {
+          const char *quote = static_cast<const char *>(memchr(m_pos, '"', m_end - m_pos));
+          if (quote == nullptr) {
+            // unterminated: the field is the rest of the data
+            field(start, size_t(m_end - start), escaped);
+            m_pos = m_end;
+            return true;
+          }
+          if (quote + 1 < m_end && quote[1] == '"') {
+            escaped = true;
+            m_pos = quote + 2;
+            continue;
+          }
+          field(start, size_t(quote - start), escaped);
+          // anything between the closing quote and the separator is ignored
+          m_pos = find_field_end(quote + 1);
+          break;
+        }
+      } else {
+        const char *stop = find_field_end(m_pos);
+        size_t len = size_t(stop - m_pos);
+        if (len > 0 && (stop == m_end || *stop == '\n') && m_pos[len - 1] == '\r') {
+          len--;
+        }
+        field(m_pos, len, false);
+        m_pos = stop;
+      }
+
+      if (m_pos >= m_end) {
+        return true;
+      }
+      if (*m_pos++ == '\n') {
+        return true;
+      }
+      // after a separator there is always another field
+      if (m_pos >= m_end) {
+        field(m_pos, 0, false);
+        return true;
+      }
+    }
+  }
+};
+
+// Makes field values, slicing the source String when possible
+class FieldMaker {
+private:
+  String *m_source;
+
+public:
+  FieldMaker(String *source) : m_source(source) { }
+
+  Value operator()(const char *data, size_t len, bool escaped) const {
+    if (escaped) {
+      std::string unescaped;
+      unescaped.reserve(len);
+      for (size_t i = 0; i < len; i++) {
+        unescaped.push_back(data[i]);
+        if (data[i] == '"' && i + 1 < len && data[i + 1] == '"') {
+          i++;
+        }
+      }
+      return Value(new String(unescaped));
+    }
+    if (m_source != nullptr) {
+      return m_source->slice(size_t(data - m_source->data()), len);
+    }
+    return Value(new String(std::string(data, len)));
+  }
+};
+
+// The String or Bytes contents of data
+void get_contents(const Value &data, const char *&contents, size_t &len, String *&source, const Location &loc) {
+  if (data.get_kind() == VALUE_STRING) {
+    source = data.get_string();
+    contents = source->data();
+    len = size_t(source->strlen());
+  } else if (data.get_kind() == VALUE_BYTES) {
+    source = nullptr;
+    contents = reinterpret_cast<const char *>(data.get_bytes()->data());
+    len = size_t(data.get_bytes()->len());
+  } else {
+    EvaluationError::raise(loc, "CSV data must be a string or bytes");
+  }
+}
+
+Value parse_int(const char *data, size_t len, const Location &loc) {
+  size_t start = len > 0 && (data[0] == '-' || data[0] == '+') ? 1 : 0;
+  size_t digits = len - start;
+  uint64_t mag = 0;
+  for (size_t i = start; i < len; i++) {
+    if (data[i] < '0' || data[i] > '9') {
+      digits = 0;
+      break;
+    }
+    mag = mag * 10 + uint64_t(data[i] - '0');
+  }
+  if (digits == 0) {
+    EvaluationError::raise(loc, "CSV field is not an integer: '%s'", std::string(data, len).c_str());
+  }
+  bool negative = data[0] == '-';
+  if (digits <= MAX_INT64_DIGITS) {
+    return Value(negative ? -int64_t(mag) : int64_t(mag));
+  }
+  Value val = BigInt::parse(std::string(data + start, digits));
+  return negative ? BigInt::sub(Value(0), val) : val;
+}
+
+}
+
+namespace csvutil {
+
+Value parse_rows(const Value &data, char sep, const Location &loc) {
+  const char *contents;
+  size_t len;
+  String *source;
+  get_contents(data, contents, len, source, loc);
+
+  FieldMaker make_field(source);
+  Parser parser(contents, len, sep);
+  std::vector<Value> rows, fields;
+  while (parser.next_record([&](const char *field, size_t field_len, bool escaped) {
+    fields.push_back(make_field(field, field_len, escaped));
+  })) {
+    rows.push_back(Value(new Array(fields)));
+    fields.clear();
+  }
+  return Value(new Array(rows));
+}
+
+Value parse_int_columns(const Value &data, char sep, const Location &loc) {
+  const char *contents;
+  size_t len;
+  String *source;
+  get_contents(data, contents, len, source, loc);
+
+  Parser parser(contents, len, sep);
+  std::vector<std::vector<Value>> columns;
+  int row = 0;
+  size_t col = 0;
+  while (parser.next_record([&](const char *field, size_t field_len, bool escaped) {
+    if (row == 0) {
+      columns.emplace_back();
+    } else if (col >= columns.size()) {
+      EvaluationError::raise(loc, "CSV record %d has more than %d fields", row + 1, int(columns.size()));
+    }
+    columns[col++].push_back(parse_int(field, field_len, loc));
+  })) {
+    if (col != columns.size()) {
+      EvaluationError::raise(loc, "CSV record %d has %d fields, not %d", row + 1, int(col), int(columns.size()));
+    }
+    row++;
+    col = 0;
+  }
+
+  std::vector<Value> result;
+  for (auto i = columns.begin(); i != columns.end(); ++i) {
+    result.push_back(Value(new Array(*i)));
+  }
+  return Value(new Array(result));
+}
+
+int each_row(InputBuffer &in, char sep, const Location &loc, const std::function<void(const Value &)> &fn) {
+  int count = 0;
+  Value line;
+  while (in.read_line(line)) {
+    // a quoted field may span lines: read until it is closed
+    String *str = line.get_string();
+    if (Parser(str->data(), size_t(str->strlen()), sep).ends_in_quote(false)) {
+      std::string record = str->get_actual_string();
+      Value more;
+      bool in_quote = true;
+      while (in_quote && in.read_line(more)) {
+        String *next = more.get_string();
+        record += '\n';
+        record.append(next->data(), next->strlen());
+        in_quote = Parser(next->data(), size_t(next->strlen()), sep).ends_in_quote(true);
+      }
+      line = Value(new String(record));
+      str = line.get_string();
+    }
+
+    FieldMaker make_field(str);
+    Parser parser(str->data(), size_t(str->strlen()), sep);
+    std::vector<Value> fields;
+    if (!parser.next_record([&](const char *field, size_t field_len, bool escaped) {
+      fields.push_back(make_field(field, field_len, escaped));
+    })) {
+      // an empty line is a record with one empty field
+      fields.push_back(make_field(str->data(), 0, false));
+    }
+    fn(Value(new Array(fields)));
+    count++;
+  }
+  return count;
+}
+
+}
@@ -0,0 +1,34 @@
+#ifndef CSV_H
+#define CSV_H
+
+#include <functional>
+#include "value.h"
+
+class InputBuffer;
+class Location;
+
+// Parsing of CSV (or other delimited) data, used by the parsecsv,
+// parsecsvints and eachcsv intrinsics.
+//
+// Records end with a newline (optionally preceded by a carriage return),
+// and fields are separated by sep.  A field may be quoted with '"', in
+// which case it may contain sep and newlines, and "" stands for a '"'.
+
+namespace csvutil {
+
+// Array of records, each an array of its fields as Strings.  data is a
+// String or Bytes; fields of a String (without "" escapes) are slices of
+// it, so they aren't copied.
+Value parse_rows(const Value &data, char sep, const Location &loc);
+
+// Array of columns, each an array of ints.  Every record must have the
+// same number of fields, and every field must be an integer.
+Value parse_int_columns(const Value &data, char sep, const Location &loc);
+
+// Call fn with each record read from in, one at a time, so that only
+// the current record is held in memory.  Returns the number of records.
+int each_row(InputBuffer &in, char sep, const Location &loc, const std::function<void(const Value &)> &fn);
+
+}
+
+#endif // CSV_H
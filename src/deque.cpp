@@ -0,0 +1,108 @@
+#include "deque.h"
+#include "exceptions.h"
+
+namespace {
+const unsigned MIN_CAPACITY = 8;
+}
+
+Deque::Deque(const std::vector<Value> &values)
+  : ValRep(VALREP_DEQUE)
+  , m_head(0)
+  , m_size(0) {
+  unsigned capacity = MIN_CAPACITY;
+  while (capacity < values.size()) {
+    capacity *= 2;
+  }
+  m_buf.resize(capacity);
+  for (auto i = values.begin(); i != values.end(); ++i) {
+    m_buf[m_size++] = *i;
+  }
+}
+
+Deque::~Deque() {
+}
+
+Value Deque::get(int index, const Location &location) const {
+  if (index >= 0 && index < m_size) {
+    return m_buf[(m_head + index) & mask()];
+  }
+  EvaluationError::raise(location, "Deque index out of bound: %d", index);
+}
+
+Value Deque::set(int index, const Value &val, const Location &location) {
+  if (index >= 0 && index < m_size) {
+    m_buf[(m_head + index) & mask()] = val;
+    return val;
+  }
+  EvaluationError::raise(location, "Deque index out of bound: %d", index);
+}
+
+Value *Deque::at(int index, const Location &location) {
+  if (index >= 0 && index < m_size) {
+    return &m_buf[(m_head + index) & mask()];
+  }
+  EvaluationError::raise(location, "Deque index out of bound: %d", index);
+}
+
+Value Deque::push_front(const Value &val) {
+  if (m_size == int(m_buf.size())) {
+    reallocate(m_buf.size() * 2);
+  }
+  m_head = (m_head - 1) & mask();
+  m_buf[m_head] = val;
+  ++m_size;
+  return val;
+}
+
+Value Deque::push_back(const Value &val) {
+  if (m_size == int(m_buf.size())) {
+    reallocate(m_buf.size() * 2);
+  }
+  m_buf[(m_head + m_size) & mask()] = val;
+  ++m_size;
+  return val;
+}
+
+Value Deque::pop_front(const Location &location) {
+  if (m_size == 0) {
+    EvaluationError::raise(location, "Popping an empty deque");
+  }
+  Value first_val = m_buf[m_head];
+  // clear the slot, so the deque doesn't keep the value alive
+  m_buf[m_head] = Value();
+  m_head = (m_head + 1) & mask();
+  --m_size;
+  shrink_if_sparse();
+  return first_val;
+}
+
+Value Deque::pop_back(const Location &location) {
+  if (m_size == 0) {
+    EvaluationError::raise(location, "Popping an empty deque");
+  }
+  unsigned last = (m_head + m_size - 1) & mask();
+  Value last_val = m_buf[last];
+  m_buf[last] = Value();
+  --m_size;
+  shrink_if_sparse();
+  return last_val;
+}
+
+// Move the elements to a new buffer with the given capacity,
+// with the first element at index 0.
+void Deque::reallocate(unsigned capacity) {
+  std::vector<Value> buf(capacity);
+  for (int i = 0; i < m_size; i++) {
+    buf[i] = m_buf[(m_head + i) & mask()];
+  }
+  m_buf.swap(buf);
+  m_head = 0;
+}
+
+void Deque::shrink_if_sparse() {
+  // halve the capacity once the deque is at most a quarter full,
+  // so alternating pushes and pops at the boundary don't thrash
+  if (m_buf.size() > MIN_CAPACITY && unsigned(m_size) <= m_buf.size() / 4) {
+    reallocate(m_buf.size() / 2);
+  }
+}
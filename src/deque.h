@@ -0,0 +1,41 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// A double-ended queue, stored in a growable ring buffer whose
+// capacity is a power of 2.  Pushing and popping at either end
+// is O(1) (amortized), and the buffer shrinks as the deque drains.
+class Deque : public ValRep {
+private:
+  std::vector<Value> m_buf;
+  unsigned m_head;  // index of the first element in m_buf
+  int m_size;
+
+public:
+  Deque(const std::vector<Value> &values);
+  virtual ~Deque();
+
+  int len() const { return m_size; }
+  Value get(int index, const Location &location) const;
+  Value set(int index, const Value &val, const Location &location);
+  // pointer to an element, valid until the deque is resized
+  Value *at(int index, const Location &location);
+
+  Value push_front(const Value &val);
+  Value push_back(const Value &val);
+  Value pop_front(const Location &location);
+  Value pop_back(const Location &location);
+
+private:
+  unsigned mask() const { return unsigned(m_buf.size()) - 1; }
+  void reallocate(unsigned capacity);
+  void shrink_if_sparse();
+};
+
+#endif //DEQUE_H
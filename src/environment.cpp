@@ -45,6 +45,16 @@ bool Environment::isDefined(const std::string &name) const {
   }
 }
 
+Value *Environment::lookup(const std::string &name) {
+  for (Environment *env = this; env != nullptr; env = env->m_parent) {
+    auto i = env->variables.find(name);
+    if (i != env->variables.end()) {
+      return &i->second;
+    }
+  }
+  return nullptr;
+}
+
 bool Environment::isDefinedInCurrentScope(const std::string &name) const {
   return variables.find(name) != variables.end();
 }
@@ -52,4 +62,8 @@ bool Environment::isDefinedInCurrentScope(const std::string &name) const {
 // A2 MS1: Add binding
 void Environment::bind(const std::string &name, const Value &value) {
   variables[name] = value;
-}
\ No newline at end of file
+}
+
+void Environment::clear() {
+  variables.clear();
+}
@@ -24,11 +24,15 @@ public:
   void setVar(const std::string &name, const Value &value);
   Value getVar(const std::string &name) const;
   bool isDefined(const std::string &name) const;
+  // pointer to the variable's value, or nullptr if it is not defined
+  Value *lookup(const std::string &name);
 
 
   // A2 MS1: Add binding
   void bind(const std::string &name, const Value &value);
   bool isDefinedInCurrentScope(const std::string &name) const;
+  // remove all variables in this scope, so it can be reused
+  void clear();
 };
 
 #endif // ENVIRONMENT_H
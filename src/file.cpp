@@ -0,0 +1,151 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "file.h"
+#include "string.h"
+#include "exceptions.h"
+
+namespace {
+
+int open_or_raise(const std::string &path, int flags, const Location &loc) {
+  int fd;
+  do {
+    fd = ::open(path.c_str(), flags, 0666);
+  } while (fd < 0 && errno == EINTR);
+  if (fd < 0) {
+    EvaluationError::raise(loc, "Cannot open file '%s': %s", path.c_str(), strerror(errno));
+  }
+  return fd;
+}
+
+}
+
+File::File(const std::string &path, int fd, bool writable)
+  : ValRep(VALREP_FILE)
+  , m_path(path)
+  , m_fd(fd)
+  , m_readers(0) {
+  if (writable) {
+    m_out.reset(new OutputBuffer(fd));
+  } else {
+    m_in.reset(new InputBuffer(fd));
+  }
+}
+
+File::~File() {
+  if (m_fd >= 0) {
+    // there's no way to raise an error here
+    int err = flush_and_close();
+    if (err != 0) {
+      fprintf(stderr, "Error: Cannot write file '%s': %s\n", m_path.c_str(), strerror(err));
+    }
+  }
+}
+
+int File::flush_and_close() {
+  int err = 0;
+  if (m_out) {
+    m_out->flush();
+    err = m_out->get_error();
+  }
+  m_out.reset();
+  m_in.reset();
+  if (::close(m_fd) != 0 && err == 0) {
+    err = errno;
+  }
+  m_fd = -1;
+  return err;
+}
+
+void File::check_output(const Location &loc) {
+  if (m_out && m_out->get_error() != 0) {
+    EvaluationError::raise(loc, "Cannot write file '%s': %s", m_path.c_str(), strerror(m_out->get_error()));
+  }
+}
+
+void File::close(const Location &loc) {
+  if (m_fd < 0) {
+    EvaluationError::raise(loc, "File '%s' is already closed", m_path.c_str());
+  }
+  if (m_readers > 0) {
+    EvaluationError::raise(loc, "Cannot close file '%s' while it is being read", m_path.c_str());
+  }
+  int err = flush_and_close();
+  if (err != 0) {
+    EvaluationError::raise(loc, "Cannot write file '%s': %s", m_path.c_str(), strerror(err));
+  }
+}
+
+Value File::open(const std::string &path, const std::string &mode, const Location &loc) {
+  int flags;
+  if (mode == "r") {
+    flags = O_RDONLY;
+  } else if (mode == "w") {
+    flags = O_WRONLY | O_CREAT | O_TRUNC;
+  } else if (mode == "a") {
+    flags = O_WRONLY | O_CREAT | O_APPEND;
+  } else {
+    EvaluationError::raise(loc, "Unknown file mode '%s'", mode.c_str());
+  }
+  int fd = open_or_raise(path, flags, loc);
+  return Value(new File(path, fd, mode != "r"));
+}
+
+Value File::read_contents(const std::string &path, const Location &loc) {
+  int fd = open_or_raise(path, O_RDONLY, loc);
+  std::string contents;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    contents.reserve(size_t(st.st_size));
+  }
+  char block[64 * 1024];
+  for (;;) {
+    ssize_t n = read(fd, block, sizeof(block));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n < 0) {
+      int err = errno;
+      ::close(fd);
+      EvaluationError::raise(loc, "Cannot read file '%s': %s", path.c_str(), strerror(err));
+    }
+    if (n == 0) {
+      break;
+    }
+    contents.append(block, size_t(n));
+  }
+  ::close(fd);
+  return Value(new String(contents));
+}
+
+Value File::map_contents(const std::string &path, const Location &loc) {
+  int fd = open_or_raise(path, O_RDONLY, loc);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    ::close(fd);
+    EvaluationError::raise(loc, "Cannot map file '%s': not a regular file", path.c_str());
+  }
+  if (st.st_size == 0) {
+    // mmap doesn't allow an empty mapping
+    ::close(fd);
+    return Value(new String(""));
+  }
+  size_t size = size_t(st.st_size);
+  std::shared_ptr<const char> mapping = map_input_file(fd, size);
+  int err = errno;
+  // the mapping stays valid after the file is closed
+  ::close(fd);
+  if (!mapping) {
+    EvaluationError::raise(loc, "Cannot map file '%s': %s", path.c_str(), strerror(err));
+  }
+  return String::view(mapping, mapping.get(), size);
+}
+
+void File::write_contents(const std::string &path, const Value &val, const Location &loc) {
+  File file(path, open_or_raise(path, O_WRONLY | O_CREAT | O_TRUNC, loc), true);
+  file.get_output()->write_value(val);
+  file.close(loc);
+}
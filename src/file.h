@@ -0,0 +1,71 @@
+#ifndef FILE_H
+#define FILE_H
+
+#include <memory>
+#include <string>
+#include "valrep.h"
+#include "value.h"
+#include "inbuf.h"
+#include "outbuf.h"
+
+class Location;
+
+// An open file, for reading or for writing (or appending), buffered
+// as standard input and output are.  The file is flushed and closed
+// by close, or else when the last reference to it goes away (when an
+// error can only be reported on stderr).
+class File : public ValRep {
+private:
+  std::string m_path;
+  int m_fd;
+  int m_readers;
+  std::unique_ptr<InputBuffer> m_in;
+  std::unique_ptr<OutputBuffer> m_out;
+
+  File(const std::string &path, int fd, bool writable);
+  // returns errno of the first error, or 0
+  int flush_and_close();
+
+public:
+  virtual ~File();
+
+  // mode is "r", "w" or "a", as for fopen
+  static Value open(const std::string &path, const std::string &mode, const Location &loc);
+
+  const std::string &get_path() const { return m_path; }
+  // the buffer for reading or writing, or nullptr if the file wasn't
+  // opened that way
+  InputBuffer *get_input() { return m_in.get(); }
+  OutputBuffer *get_output() { return m_out.get(); }
+
+  // Raise an EvaluationError if any output couldn't be written
+  void check_output(const Location &loc);
+  // Flush and close the file, raising an EvaluationError if any output
+  // couldn't be written; afterwards the file can't be read or written
+  void close(const Location &loc);
+
+  // While a Reading exists, the file is being read through its input
+  // buffer (by a function that calls back into the program between
+  // reads), so close refuses to free the buffer
+  class Reading {
+  private:
+    File *m_file;
+
+    Reading(const Reading &);
+    Reading &operator=(const Reading &);
+
+  public:
+    Reading(File *file) : m_file(file) { m_file->m_readers++; }
+    ~Reading() { m_file->m_readers--; }
+  };
+
+  // The whole contents of a file, copied into a String
+  static Value read_contents(const std::string &path, const Location &loc);
+  // The whole contents of a file, as a String viewing a memory mapping
+  // of it (so the file shouldn't be changed while the String is in use)
+  static Value map_contents(const std::string &path, const Location &loc);
+  // Replace the contents of a file with a value, formatted as by print
+  static void write_contents(const std::string &path, const Value &val, const Location &loc);
+};
+
+#endif // FILE_H
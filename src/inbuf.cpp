@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "inbuf.h"
+#include "string.h"
+#include "bigint.h"
+
+namespace {
+
+const size_t INPUT_BLOCK_SIZE = 64 * 1024;
+
+// Integers with at most this many digits fit in 64 bits
+const size_t MAX_INT64_DIGITS = 18;
+
+}
+
+InputBuffer::InputBuffer(int fd)
+  : m_fd(fd)
+  , m_started(false)
+  , m_eof(false)
+  , m_pos(nullptr)
+  , m_end(nullptr) {
+}
+
+InputBuffer::~InputBuffer() {
+}
+
+bool InputBuffer::map_input() {
+  struct stat st;
+  if (fstat(m_fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  off_t offset = lseek(m_fd, 0, SEEK_CUR);
+  if (offset < 0 || offset >= st.st_size) {
+    return false;
+  }
+  size_t size = size_t(st.st_size);
+  std::shared_ptr<const char> mapping = map_input_file(m_fd, size);
+  if (!mapping) {
+    return false;
+  }
+  m_storage = mapping;
+  m_pos = mapping.get() + offset;
+  m_end = mapping.get() + size;
+  // the mapping is all the input there is
+  m_eof = true;
+  lseek(m_fd, 0, SEEK_END);
+  return true;
+}
+
+bool InputBuffer::fill(bool to_eof) {
+  if (!m_started) {
+    m_started = true;
+    if (map_input()) {
+      return true;
+    }
+  }
+  if (m_eof) {
+    return false;
+  }
+
+  // read into a new block, starting with the unread input: the
+  // current block may be referred to by Strings
+  size_t unread = size_t(m_end - m_pos);
+  size_t size = std::max(INPUT_BLOCK_SIZE, unread * 2);
+  char *block = new char[size];
+  if (unread > 0) {
+    memcpy(block, m_pos, unread);
+  }
+  size_t got = 0;
+  while (unread + got < size) {
+    ssize_t n = read(m_fd, block + unread + got, size - unread - got);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      m_eof = true;
+      break;
+    }
+    bool newline = memchr(block + unread + got, '\n', size_t(n)) != nullptr;
+    got += size_t(n);
+    if (!to_eof && (got >= unread || newline)) {
+      break;
+    }
+  }
+  if (got == 0) {
+    delete[] block;
+    return false;
+  }
+  m_storage.reset(block, std::default_delete<const char[]>());
+  m_pos = block;
+  m_end = block + unread + got;
+  return true;
+}
+
+bool InputBuffer::at_end() {
+  int c;
+  while ((c = peek(0)) >= 0 && isspace(c)) {
+    m_pos++;
+  }
+  return c < 0;
+}
+
+bool InputBuffer::read_int(Value &val) {
+  if (at_end()) {
+    return false;
+  }
+  size_t start = (peek(0) == '-' || peek(0) == '+') ? 1 : 0;
+  size_t i = start;
+  uint64_t mag = 0;
+  int c;
+  while ((c = peek(i)) >= '0' && c <= '9') {
+    mag = mag * 10 + uint64_t(c - '0');
+    i++;
+  }
+  size_t digits = i - start;
+  if (digits == 0) {
+    return false;
+  }
+  bool negative = m_pos[0] == '-';
+  if (digits <= MAX_INT64_DIGITS) {
+    val = Value(negative ? -int64_t(mag) : int64_t(mag));
+  } else {
+    // too long for the fast path: may not fit in 64 bits
+    val = BigInt::parse(std::string(m_pos + start, digits));
+    if (negative) {
+      val = BigInt::sub(Value(int64_t(0)), val);
+    }
+  }
+  m_pos += i;
+  return true;
+}
+
+bool InputBuffer::read_line(Value &line) {
+  size_t searched = 0;
+  const char *newline = nullptr;
+  for (;;) {
+    if (m_pos + searched < m_end) {
+      newline = static_cast<const char *>(memchr(m_pos + searched, '\n', m_end - m_pos - searched));
+      if (newline != nullptr) {
+        break;
+      }
+    }
+    searched = size_t(m_end - m_pos);
+    if (!fill()) {
+      break;
+    }
+  }
+  if (newline == nullptr) {
+    // the last line may not end with a newline
+    if (m_pos == m_end) {
+      return false;
+    }
+    newline = m_end;
+  }
+  line = String::view(m_storage, m_pos, size_t(newline - m_pos));
+  m_pos = newline == m_end ? m_end : newline + 1;
+  return true;
+}
+
+Value InputBuffer::read_all() {
+  while (fill(true)) {
+  }
+  Value all = String::view(m_storage, m_pos, size_t(m_end - m_pos));
+  m_pos = m_end;
+  return all;
+}
+
+std::shared_ptr<const char> map_input_file(int fd, size_t size) {
+  void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  madvise(addr, size, MADV_SEQUENTIAL);
+  return std::shared_ptr<const char>(static_cast<const char *>(addr),
+                                     [size](const char *p) { munmap(const_cast<char *>(p), size); });
+}
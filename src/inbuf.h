@@ -0,0 +1,67 @@
+#ifndef INBUF_H
+#define INBUF_H
+
+#include <cstddef>
+#include <memory>
+#include "value.h"
+
+// A buffer for a program's input, read from a file descriptor in large
+// blocks with read(2), or memory-mapped all at once if it is a regular
+// file.  Integers are parsed straight from the buffer, and lines and
+// the rest of the input are returned as Strings that view the buffer
+// rather than copying it: each block of the buffer is shared by the
+// Strings that refer to it, so it is never overwritten.
+//
+// Nothing is read until the program asks for input.
+class InputBuffer {
+private:
+  int m_fd;
+  bool m_started;
+  bool m_eof;
+  std::shared_ptr<const char> m_storage;
+  const char *m_pos, *m_end;
+
+  // copying would read the same input twice
+  InputBuffer(const InputBuffer &);
+  InputBuffer &operator=(const InputBuffer &);
+
+  // Make more input available after m_pos, keeping the unread input.
+  // Since the unread input is copied, this reads at least as much new
+  // input as was unread (so the copying is amortized), unless a newline
+  // arrives first, so interactive input isn't held up; if to_eof, it
+  // reads until the new block is full.  Returns false at the end of
+  // the input.
+  bool fill(bool to_eof = false);
+  bool map_input();
+  // the byte at offset i from m_pos, or -1 at the end of the input
+  int peek(size_t i) {
+    while (m_pos + i >= m_end) {
+      if (!fill()) {
+        return -1;
+      }
+    }
+    return (unsigned char) m_pos[i];
+  }
+
+public:
+  InputBuffer(int fd);
+  ~InputBuffer();
+
+  // Skip whitespace; returns true if there is no more input
+  bool at_end();
+  // Read an optionally signed decimal integer, after any whitespace;
+  // returns false (reading nothing) if there isn't one
+  bool read_int(Value &val);
+  // Read the next line, without its newline; returns false at the
+  // end of the input
+  bool read_line(Value &line);
+  // All the remaining input
+  Value read_all();
+};
+
+// Map the first size bytes of a file read-only, for reading sequentially.
+// The mapping lasts as long as the returned pointer (or a copy of it);
+// returns nullptr if the file can't be mapped.
+std::shared_ptr<const char> map_input_file(int fd, size_t size);
+
+#endif // INBUF_H
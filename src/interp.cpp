@@ -1,7 +1,9 @@
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <memory>
 #include <set>
+#include <unistd.h>
 #include "ast.h"
 #include "node.h"
 #include "exceptions.h"
@@ -9,7 +11,10 @@
 #include "interp.h"
 
 Interpreter::Interpreter(Node *ast_to_adopt)
-  : m_ast(ast_to_adopt) {
+  : m_ast(ast_to_adopt)
+  , m_flow(FLOW_NORMAL)
+  , m_in(STDIN_FILENO)
+  , m_out(STDOUT_FILENO) {
 }
 
 Interpreter::~Interpreter() {
@@ -44,7 +49,20 @@ void Interpreter::analyzeHelper(Node* node, std::set<std::string>& definedVariab
 void Interpreter::analyze() {
   // Done: implement
   std::set<std::string> definedVariables = {
-      "print", "println", "readint", "mkarr", "len", "get", "set", "push", "pop", "substr", "strcat", "strlen"
+      "print", "println", "readint", "mkarr", "len", "get", "set", "push", "pop", "substr", "strcat", "strlen",
+      "intern", "strfind", "strcount", "split",
+      "mkbytes", "tobytes", "bytestr", "byteat", "setbyte", "bappend",
+      "mkmap", "mget", "mput", "mhas", "mdel", "mkeys",
+      "mkbitset", "bset", "bclear", "btest", "bcount", "bunion", "bintersect",
+      "mkdeque", "pushfront", "pushback", "popfront", "popback",
+      "mkpq", "pqpush", "pqpop", "pqpeek", "pqlen",
+      "sort", "sortby",
+      "mkmat", "matget", "matset", "matrows", "matcols", "matrow", "matcol",
+      "transpose", "matmul", "matadd", "matsub", "matemul",
+      "soa", "toint", "tofloat", "popcount", "clz", "ctz",
+      "readints", "readline", "readall", "openfile", "closefile", "readfile", "mapfile", "writefile",
+      "mkarrmapped", "finisharr", "openarr", "serialize", "deserialize",
+      "parsecsv", "parsecsvints", "eachcsv"
   };
 
   analyzeHelper(m_ast, definedVariables);
@@ -54,20 +72,92 @@ void Interpreter::analyze() {
 Value Interpreter::execute() {
   // Done: implement
   Environment* global_env = new Environment();
+  // deleted even if evaluation raises an error, so that values needing
+  // cleanup (e.g., unfinished mapped arrays) get it
+  std::unique_ptr<Environment> global_env_owner(global_env);
 
   // Bind intrinsic functions
   global_env->bind("print", Value(&intrinsic_print));
   global_env->bind("println", Value(&intrinsic_println));
   global_env->bind("readint", Value(&intrinsic_readint));
+  global_env->bind("readints", Value(&intrinsic_readints));
+  global_env->bind("readline", Value(&intrinsic_readline));
+  global_env->bind("readall", Value(&intrinsic_readall));
+  global_env->bind("openfile", &file_openfile);
+  global_env->bind("closefile", &file_closefile);
+  global_env->bind("readfile", &file_readfile);
+  global_env->bind("mapfile", &file_mapfile);
+  global_env->bind("writefile", &file_writefile);
+  global_env->bind("mkarrmapped", &array_mkarrmapped);
+  global_env->bind("finisharr", &array_finisharr);
+  global_env->bind("openarr", &array_openarr);
+  global_env->bind("serialize", &intrinsic_serialize);
+  global_env->bind("deserialize", &intrinsic_deserialize);
+  global_env->bind("parsecsv", &csv_parsecsv);
+  global_env->bind("parsecsvints", &csv_parsecsvints);
+  global_env->bind("eachcsv", &csv_eachcsv);
+  global_env->bind("toint", &number_toint);
+  global_env->bind("tofloat", &number_tofloat);
+  global_env->bind("popcount", &number_popcount);
+  global_env->bind("clz", &number_clz);
+  global_env->bind("ctz", &number_ctz);
   global_env->bind("mkarr", &array_mkarr);
   global_env->bind("len", &array_len);
   global_env->bind("get", &array_get);
   global_env->bind("set", &array_set);
   global_env->bind("push", &array_push);
   global_env->bind("pop", &array_pop);
+  global_env->bind("sort", &array_sort);
+  global_env->bind("sortby", &array_sortby);
+  global_env->bind("soa", &record_soa);
   global_env->bind("substr", &string_substr);
   global_env->bind("strcat", &string_strcat);
   global_env->bind("strlen", &string_strlen);
+  global_env->bind("intern", &string_intern);
+  global_env->bind("strfind", &string_strfind);
+  global_env->bind("strcount", &string_strcount);
+  global_env->bind("split", &string_split);
+  global_env->bind("mkbytes", &bytes_mkbytes);
+  global_env->bind("tobytes", &bytes_tobytes);
+  global_env->bind("bytestr", &bytes_bytestr);
+  global_env->bind("byteat", &bytes_byteat);
+  global_env->bind("setbyte", &bytes_setbyte);
+  global_env->bind("bappend", &bytes_bappend);
+  global_env->bind("mkmap", &map_mkmap);
+  global_env->bind("mget", &map_mget);
+  global_env->bind("mput", &map_mput);
+  global_env->bind("mhas", &map_mhas);
+  global_env->bind("mdel", &map_mdel);
+  global_env->bind("mkeys", &map_mkeys);
+  global_env->bind("mkbitset", &bitset_mkbitset);
+  global_env->bind("bset", &bitset_bset);
+  global_env->bind("bclear", &bitset_bclear);
+  global_env->bind("btest", &bitset_btest);
+  global_env->bind("bcount", &bitset_bcount);
+  global_env->bind("bunion", &bitset_bunion);
+  global_env->bind("bintersect", &bitset_bintersect);
+  global_env->bind("mkdeque", &deque_mkdeque);
+  global_env->bind("pushfront", &deque_pushfront);
+  global_env->bind("pushback", &deque_pushback);
+  global_env->bind("popfront", &deque_popfront);
+  global_env->bind("popback", &deque_popback);
+  global_env->bind("mkpq", &pqueue_mkpq);
+  global_env->bind("pqpush", &pqueue_pqpush);
+  global_env->bind("pqpop", &pqueue_pqpop);
+  global_env->bind("pqpeek", &pqueue_pqpeek);
+  global_env->bind("pqlen", &pqueue_pqlen);
+  global_env->bind("mkmat", &matrix_mkmat);
+  global_env->bind("matget", &matrix_matget);
+  global_env->bind("matset", &matrix_matset);
+  global_env->bind("matrows", &matrix_matrows);
+  global_env->bind("matcols", &matrix_matcols);
+  global_env->bind("matrow", &matrix_matrow);
+  global_env->bind("matcol", &matrix_matcol);
+  global_env->bind("transpose", &matrix_transpose);
+  global_env->bind("matmul", &matrix_matmul);
+  global_env->bind("matadd", &matrix_matadd);
+  global_env->bind("matsub", &matrix_matsub);
+  global_env->bind("matemul", &matrix_matemul);
 
   // Will hold the value of the last statement executed
   Value result;
@@ -78,11 +168,12 @@ Value Interpreter::execute() {
     Node *statm_ast = m_ast->get_kid(i);
     if (statm_ast->get_tag() == AST_FUNCTION) {
       result = create_function(statm_ast, global_env);
+    } else if (statm_ast->get_tag() == AST_RECORD) {
+      result = create_record(statm_ast, global_env);
     } else {
       result = evaluate(statm_ast->get_kid(0), global_env);
     }
   }
-  delete global_env;
   return result;
 }
 
@@ -96,10 +187,79 @@ Value Interpreter::execute(Node *node, Environment *env) {
   for (int i = 0; i < nkids; i++) {
     Node *statm_ast = node->get_kid(i);
     result = evaluate(statm_ast->get_kid(0), env);
+    if (m_flow != FLOW_NORMAL) {
+      // break, continue or return: skip the rest of the statements
+      break;
+    }
   }
   return result;
 }
 
+Value Interpreter::intern(const std::string &str) {
+  auto i = m_interned.find(str);
+  if (i != m_interned.end()) {
+    return i->second;
+  }
+  Value value(new String(str));
+  m_interned.emplace(str, value);
+  return value;
+}
+
+Value Interpreter::call_function(const Value &fn, Value args[], unsigned num_args, const Location &loc) {
+  switch (fn.get_kind()) {
+    case VALUE_FUNCTION: {
+      // if function is user-defined
+      Function* function = fn.get_function();
+
+      // check number of arguments
+      if (num_args != function->get_num_params()) {
+        EvaluationError::raise(loc,
+                               "%s", ("Function '" + function->get_name() + "' requires " +
+                                      std::to_string(function->get_num_params()) + " arguments").c_str());
+      }
+
+      // Function call environment
+      Environment* fncall_env = new Environment(function -> get_parent_env());
+      for (unsigned i = 0; i < num_args; i++) {
+        fncall_env->bind(function->get_param_name(i), args[i]);
+      }
+
+      Environment *block_env = new Environment(fncall_env);
+
+      // execute function
+      Value result = execute(function->get_body(), block_env);
+      if (m_flow == FLOW_RETURN) {
+        result = m_return_value;
+        m_return_value = Value();
+        m_flow = FLOW_NORMAL;
+      }
+
+      // delete function call environment
+      delete fncall_env;
+      delete block_env;
+
+      return result;
+    };
+    case VALUE_INTRINSIC_FN: {
+      // if function is intrinsic
+      IntrinsicFn function = fn.get_intrinsic_fn();
+      return function(args, num_args, loc, this);
+    };
+    case VALUE_SHAPE: {
+      // calling a record type constructs a record
+      Shape *shape = fn.get_shape();
+      if (int(num_args) != shape->get_num_fields()) {
+        EvaluationError::raise(loc,
+                               "%s", ("Record '" + shape->get_name() + "' requires " +
+                                      std::to_string(shape->get_num_fields()) + " fields").c_str());
+      }
+      return Value(new Record(shape, std::vector<Value>(args, args + num_args)));
+    };
+    default:
+      EvaluationError::raise(loc, "Invalid function type");
+  }
+}
+
 Value Interpreter::create_function(Node* node, Environment* env) {
   // if astnode is function definition
   Node* identifierNode = node->get_kid(0);
@@ -130,6 +290,42 @@ Value Interpreter::create_function(Node* node, Environment* env) {
   return value;
 }
 
+Value Interpreter::create_record(Node* node, Environment* env) {
+  // if astnode is record declaration
+  std::string record_name = node->get_kid(0)->get_str();
+
+  std::vector<std::string> field_names;
+  Node* fieldListNode = node->get_kid(1);
+  for (unsigned i = 0; i < fieldListNode->get_num_kids(); i++) {
+    std::string field_name = fieldListNode->get_kid(i)->get_str();
+    if (std::find(field_names.begin(), field_names.end(), field_name) != field_names.end()) {
+      EvaluationError::raise(fieldListNode->get_kid(i)->get_loc(),
+                             "%s", ("Duplicate field '" + field_name + "'").c_str());
+    }
+    field_names.push_back(field_name);
+  }
+
+  // bind the record type (which is also its constructor) to environment
+  env->bind(record_name, Value(new Shape(record_name, field_names)));
+  Value value(0);
+  return value;
+}
+
+int Interpreter::find_field_slot(Node *node, Shape *shape) {
+  // the node caches the slot for the last shape it saw, so repeated
+  // accesses to records of the same type skip the lookup by name
+  if (node->get_cached_shape_id() == shape->get_id()) {
+    return node->get_cached_slot();
+  }
+  int slot = shape->find_slot(node->get_str());
+  if (slot < 0) {
+    EvaluationError::raise(node->get_loc(),
+                           "%s", ("Record '" + shape->get_name() + "' has no field '" + node->get_str() + "'").c_str());
+  }
+  node->set_field_cache(shape->get_id(), slot);
+  return slot;
+}
+
 Value Interpreter::evaluate(Node* node, Environment* env) {
   if (!node) {
     return {0}; // Return default (0) value for null node
@@ -139,9 +335,15 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
     case AST_INT_LITERAL: {
       // if astnode is literal
       // return literal value encoded by astnode
-      int intValue = std::stoi(node->get_str());
-      Value value(intValue);
-      return value;
+      // literals too large for 64 bits are bigints
+      const std::string &digits = node->get_str();
+      if (digits.size() < 19) {
+        return Value(int64_t(std::stoll(digits)));
+      }
+      return BigInt::parse(digits);
+    };
+    case AST_FLOAT_LITERAL: {
+      return Value(std::strtod(node->get_str().c_str(), nullptr));
     };
     case AST_VARREF: {
       // astnode is variable reference
@@ -156,9 +358,8 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
       Node* varNode = node->get_kid(0);
       Node* exprNode = node->get_kid(1);
       Value childval = evaluate(exprNode, env);
-      std::string identifier = varNode->get_str();
       // update value of variable and return childval
-      env->setVar(check_exists(identifier, env, node), childval);
+      *lookup_variable(varNode, env) = childval;
       return childval;
     };
     case AST_VARDEF: {
@@ -181,7 +382,7 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
       Value conditionValue = evaluate(conditionNode, env);
       if (nkids == 2) {
         // if (condition) {block}
-        if (conditionValue.get_ival() != 0) {
+        if (is_true(conditionValue)) {
           // if condition is true, execute block
           Environment* new_env = new Environment(env);
           Value result = execute(blockNode, new_env);
@@ -190,7 +391,7 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
       } else if (nkids == 3) {
         // if (condition) {block} else {block}
         Node* elseBlockNode = node->get_kid(2);
-        if (conditionValue.get_ival() != 0) {
+        if (is_true(conditionValue)) {
           // if condition is true, execute block
           Environment* new_env = new Environment(env);
           Value result = execute(blockNode, new_env);
@@ -210,14 +411,52 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
       Environment* new_env = new Environment(env);
       Value conditionValue = evaluate(conditionNode, new_env);
       delete new_env;
-      while (conditionValue.get_ival() != 0) {
+      while (is_true(conditionValue)) {
         Environment* new_env = new Environment(env);
         Value result = execute(blockNode, new_env);
+        if (m_flow != FLOW_NORMAL && leave_loop()) {
+          delete new_env;
+          break;
+        }
         conditionValue = evaluate(conditionNode, new_env);
         delete new_env;
       }
       return Value(0);
     };
+    case AST_BREAK: {
+      m_flow = FLOW_BREAK;
+      return Value(0);
+    };
+    case AST_CONTINUE: {
+      m_flow = FLOW_CONTINUE;
+      return Value(0);
+    };
+    case AST_RETURN: {
+      m_return_value = evaluate(node->get_kid(0), env);
+      m_flow = FLOW_RETURN;
+      return m_return_value;
+    };
+    case AST_SWITCH: {
+      Value switchValue = evaluate(node->get_kid(0), env);
+      if (!switchValue.is_integer()) {
+        EvaluationError::raise(node->get_loc(), "Switch value must be an integer");
+      }
+      // a bigint can't match any case
+      int kid = switchValue.get_kind() == VALUE_INT ? node->find_case(switchValue.get_ival()) : node->get_default_case();
+      if (kid >= 0) {
+        Environment case_env(env);
+        execute(node->get_kid(kid)->get_kid(0), &case_env);
+        if (m_flow == FLOW_BREAK) {
+          // break leaves the switch, not an enclosing loop
+          m_flow = FLOW_NORMAL;
+        }
+      }
+      return Value(0);
+    };
+    case AST_FOR_RANGE:
+      return evaluate_for_range(node, env);
+    case AST_FOR_EACH:
+      return evaluate_for_each(node, env);
     case AST_FNCALL: {
       // if astnode is function call
       Node* identifierNode = node->get_kid(0);
@@ -226,111 +465,113 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
       // get function from environment
       Value functionValue = env->getVar(check_exists(identifier, env, node));
       enum ValueKind kind = functionValue.get_kind();
-      switch (kind) {
-        case VALUE_FUNCTION: {
-          // if function is user-defined
-          Function* function = functionValue.get_function();
-
-          // Function call environment
-          Environment* fncall_env = new Environment(function -> get_parent_env());
-
-          // check number of arguments
-          Node* argListNode = node->get_kid(1);
-          int numArgs = argListNode->get_num_kids();
-
-          if (numArgs != function->get_num_params()) {
-            EvaluationError::raise(node->get_loc(),
-                                   "%s", ("Function '" + identifier + "' requires " +
-                                          std::to_string(function->get_num_params()) + " arguments").c_str());
-          }
-
-          // prepare arguments
-          for (int i = 0; i < numArgs; i++) {
-            Node* argNode = argListNode->get_kid(i);
-            Value argValue = evaluate(argNode, env);
-            std::string param_name = function->get_param_name(i);
-            fncall_env->bind(param_name, argValue);
-          }
-
-          Environment *block_env = new Environment(fncall_env);
-
-          // execute function
-          Value result = execute(function->get_body(), block_env);
-
-          // delete function call environment
-          delete fncall_env;
-          delete block_env;
-
-          return result;
+      if (kind != VALUE_FUNCTION && kind != VALUE_INTRINSIC_FN && kind != VALUE_SHAPE) {
+        EvaluationError::raise(node->get_loc(), "Invalid function type");
+      }
 
-        };
-        case VALUE_INTRINSIC_FN: {
-          // if function is intrinsic
-          IntrinsicFn function = functionValue.get_intrinsic_fn();
-
-          // prepare arguments
-          Node* argListNode = node->get_kid(1);
-          int numArgs = argListNode->get_num_kids();
-          Value arguments[numArgs];
-          for (int i = 0; i < numArgs; i++) {
-            Node* argNode = argListNode->get_kid(i);
-            Value argValue = evaluate(argNode, env);
-            arguments[i] = argValue;
-          }
-
-          // call intrinsic function
-          Value result = function(arguments, numArgs, node->get_loc(), this);
-          return result;
-        };
-        default:
-          EvaluationError::raise(node->get_loc(), "Invalid function type");
+      // prepare arguments
+      Node* argListNode = node->get_kid(1);
+      int numArgs = argListNode->get_num_kids();
+      Value arguments[numArgs];
+      for (int i = 0; i < numArgs; i++) {
+        Node* argNode = argListNode->get_kid(i);
+        arguments[i] = evaluate(argNode, env);
       }
 
+      return call_function(functionValue, arguments, numArgs, node->get_loc());
+    };
+    case AST_FIELDREF: {
+      // if astnode is field access
+      Value object = evaluate(node->get_kid(0), env);
+      if (object.get_kind() == VALUE_RECORD) {
+        Record *record = object.get_record();
+        return record->get(find_field_slot(node, record->get_shape()));
+      } else if (object.get_kind() == VALUE_RECORD_ARRAY) {
+        // the field of an array of records is the array of that field's values
+        RecordArray *records = object.get_record_array();
+        return records->column(find_field_slot(node, records->get_shape()));
+      }
+      EvaluationError::raise(node->get_loc(), "Field access on a value that is not a record");
+    };
+    case AST_FIELD_ASSIGN: {
+      // if astnode is field assignment
+      Node* fieldNode = node->get_kid(0);
+      int index;
+      Value object = evaluate_field_owner(fieldNode, env, index);
+      Value childval = evaluate(node->get_kid(1), env);
+      *find_field(fieldNode, object, index) = childval;
+      return childval;
     };
+    case AST_INDEX: {
+      // if astnode is element access
+      Value container = evaluate(node->get_kid(0), env);
+      Value index = evaluate(node->get_kid(1), env);
+      return evaluate_index(node, container, index);
+    };
+    case AST_INDEX_ASSIGN: {
+      // if astnode is element assignment
+      Node* indexNode = node->get_kid(0);
+      Value container = evaluate(indexNode->get_kid(0), env);
+      Value index = evaluate(indexNode->get_kid(1), env);
+      Value childval = evaluate(node->get_kid(1), env);
+      return store_index(indexNode, container, index, childval);
+    };
+    case AST_ADD_ASSIGN:
+    case AST_SUB_ASSIGN:
+    case AST_MULTIPLY_ASSIGN:
+    case AST_DIVIDE_ASSIGN:
+    case AST_INCREMENT:
+    case AST_DECREMENT:
+      return evaluate_update(node, env);
     case AST_STRING_LITERAL: {
       // if astnode is string literal
-      return Value(new String(node->get_str()));
+      return intern(node->get_str());
     };
     default:
       // astnode is binary operation
-      Value left = evaluate_and_check_numeric(node, env, 0);
+      Value left = evaluate(node->get_kid(0), env);
+
+      // strings are compared by contents
+      if (left.get_kind() == VALUE_STRING) {
+        return evaluate_string_comparison(node, left, evaluate(node->get_kid(1), env));
+      }
+      check_numeric(left, node);
 
       // Done: support for short-circuiting and result casting
       if (tag == AST_LOGICAL_AND) {
-        if (left.get_ival() == 0) {
+        if (!is_true(left)) {
           return Value(0);
         }
         Value right = evaluate_and_check_numeric(node, env, 1);
-        return Value(right.get_ival() ? 1 : 0);
+        return Value(is_true(right) ? 1 : 0);
       } else if (tag == AST_LOGICAL_OR) {
-        if (left.get_ival() != 0) {
+        if (is_true(left)) {
           return Value(1);
         }
         Value right = evaluate_and_check_numeric(node, env, 1);
-        return Value(right.get_ival() ? 1 : 0);
+        return Value(is_true(right) ? 1 : 0);
       }
       Value right = evaluate_and_check_numeric(node, env, 1);
 
+      if (left.get_kind() != VALUE_INT || right.get_kind() != VALUE_INT) {
+        if (is_comparison(tag)) {
+          return evaluate_numeric_comparison(tag, left, right);
+        }
+      }
+
       switch (tag) {
-        case AST_ADD: {
-          int res = right.get_ival() + left.get_ival();
-          return Value(res);
-        };
-        case AST_SUB: {
-          int res = left.get_ival() - right.get_ival();
-          return Value(res);
-        };
-        case AST_MULTIPLY: {
-          int res = right.get_ival() * left.get_ival();
-          return Value(res);
-        };
-        case AST_DIVIDE: {
-          if (right.get_ival() == 0) {
-            EvaluationError::raise(node->get_loc(), "Attempt to divide by 0");
-          }
-          int res = left.get_ival() / right.get_ival();
-          return Value(res);
-        };
+        case AST_ADD:
+        case AST_SUB:
+        case AST_MULTIPLY:
+        case AST_DIVIDE:
+        case AST_MODULO:
+          return evaluate_arithmetic(tag, left, right, node);
+        case AST_BITAND:
+        case AST_BITOR:
+        case AST_BITXOR:
+        case AST_SHIFT_LEFT:
+        case AST_SHIFT_RIGHT:
+          return evaluate_bitwise(tag, left, right, node);
         case AST_LESS: {
           int res = left.get_ival() < right.get_ival();
           return Value(res);
@@ -364,14 +605,472 @@ Value Interpreter::evaluate(Node* node, Environment* env) {
 }
 
 
+Value Interpreter::evaluate_for_range(Node *node, Environment *env) {
+  Value lo = evaluate_and_check_numeric(node, env, 1);
+  Value hi = evaluate_and_check_numeric(node, env, 2);
+  Node* blockNode = node->get_kid(3);
+  if (!lo.is_integer() || !hi.is_integer()) {
+    EvaluationError::raise(node->get_loc(), "For loop range must be integers");
+  }
+  if (lo.get_kind() != VALUE_INT || hi.get_kind() != VALUE_INT) {
+    EvaluationError::raise(node->get_loc(), "For loop range is too large");
+  }
+
+  // the loop variable lives in its own frame, and the body's
+  // environment is reused (after clearing it) by every iteration
+  Environment loop_env(env);
+  loop_env.bind(node->get_kid(0)->get_str(), lo);
+  Value *counter = loop_env.lookup(node->get_kid(0)->get_str());
+  Environment block_env(&loop_env);
+
+  // the counter is native: assigning to the loop variable in the
+  // body doesn't change the number of iterations
+  for (int64_t i = lo.get_ival(), end = hi.get_ival(); i < end; i++) {
+    *counter = Value(i);
+    execute(blockNode, &block_env);
+    block_env.clear();
+    if (m_flow != FLOW_NORMAL && leave_loop()) {
+      break;
+    }
+  }
+  return Value(0);
+}
+
+// Called when a loop body stopped early.  Returns true if the loop
+// should exit (on break or return), or false to go on with the next
+// iteration (on continue).
+bool Interpreter::leave_loop() {
+  if (m_flow == FLOW_RETURN) {
+    // leave the status set, so that the function call sees it
+    return true;
+  }
+  bool exits = m_flow == FLOW_BREAK;
+  m_flow = FLOW_NORMAL;
+  return exits;
+}
+
+// Number of elements a for loop visits in a container
+static int iteration_count(const Value &container) {
+  switch (container.get_kind()) {
+    case VALUE_ARRAY:
+      return container.get_array()->len();
+    case VALUE_DEQUE:
+      return container.get_deque()->len();
+    case VALUE_RECORD_ARRAY:
+      return container.get_record_array()->len();
+    case VALUE_BYTES:
+      return container.get_bytes()->len();
+    case VALUE_MAPPED_ARRAY:
+      return container.get_mapped_array()->len();
+    default:
+      return container.get_string()->strlen();
+  }
+}
+
+Value Interpreter::evaluate_for_each(Node *node, Environment *env) {
+  Value container = evaluate(node->get_kid(1), env);
+  Node* blockNode = node->get_kid(2);
+  switch (container.get_kind()) {
+    case VALUE_ARRAY:
+    case VALUE_DEQUE:
+    case VALUE_RECORD_ARRAY:
+    case VALUE_BYTES:
+    case VALUE_STRING:
+    case VALUE_MAPPED_ARRAY:
+      break;
+    case VALUE_MAP:
+      // iterate over a snapshot of the keys
+      container = container.get_map()->keys();
+      break;
+    default:
+      EvaluationError::raise(node->get_loc(), "For loop over a value that is not an array, deque, map, bytes or string");
+  }
+
+  Environment loop_env(env);
+  loop_env.bind(node->get_kid(0)->get_str(), Value(0));
+  Value *element = loop_env.lookup(node->get_kid(0)->get_str());
+  Environment block_env(&loop_env);
+
+  // the length is checked on each iteration, since the body may change it
+  for (int i = 0; i < iteration_count(container); i++) {
+    *element = evaluate_index(node, container, Value(i));
+    execute(blockNode, &block_env);
+    block_env.clear();
+    if (m_flow != FLOW_NORMAL && leave_loop()) {
+      break;
+    }
+  }
+  return Value(0);
+}
+
+Value Interpreter::evaluate_arithmetic(int tag, const Value &left, const Value &right, Node *node) {
+  if (left.get_kind() == VALUE_INT && right.get_kind() == VALUE_INT) {
+    // fast path: 64-bit arithmetic, unless the result overflows
+    int64_t l = left.get_ival(), r = right.get_ival(), res;
+    switch (tag) {
+      case AST_ADD:
+        if (!__builtin_add_overflow(l, r, &res)) {
+          return Value(res);
+        }
+        break;
+      case AST_SUB:
+        if (!__builtin_sub_overflow(l, r, &res)) {
+          return Value(res);
+        }
+        break;
+      case AST_MULTIPLY:
+        if (!__builtin_mul_overflow(l, r, &res)) {
+          return Value(res);
+        }
+        break;
+      case AST_MODULO:
+        if (r == 0) {
+          EvaluationError::raise(node->get_loc(), "Attempt to divide by 0");
+        }
+        // INT64_MIN % -1 overflows in hardware, but is just 0
+        return Value(r == -1 ? int64_t(0) : l % r);
+      default:
+        if (r == 0) {
+          EvaluationError::raise(node->get_loc(), "Attempt to divide by 0");
+        }
+        if (!(l == INT64_MIN && r == -1)) {
+          return Value(l / r);
+        }
+        break;
+    }
+  }
+
+  if (left.get_kind() == VALUE_DOUBLE || right.get_kind() == VALUE_DOUBLE) {
+    // an int operand is converted to double; division by zero
+    // follows IEEE 754 (giving an infinity or NaN)
+    double l = left.to_double(), r = right.to_double();
+    switch (tag) {
+      case AST_ADD:
+        return Value(l + r);
+      case AST_SUB:
+        return Value(l - r);
+      case AST_MULTIPLY:
+        return Value(l * r);
+      case AST_MODULO:
+        return Value(std::fmod(l, r));
+      default:
+        return Value(l / r);
+    }
+  }
+
+  // a bigint operand, or the result overflowed
+  switch (tag) {
+    case AST_ADD:
+      return BigInt::add(left, right);
+    case AST_SUB:
+      return BigInt::sub(left, right);
+    case AST_MULTIPLY:
+      return BigInt::mul(left, right);
+    default:
+      if (right.get_kind() == VALUE_INT && right.get_ival() == 0) {
+        EvaluationError::raise(node->get_loc(), "Attempt to divide by 0");
+      }
+      return tag == AST_MODULO ? BigInt::rem(left, right) : BigInt::div(left, right);
+  }
+}
+
+Value Interpreter::evaluate_bitwise(int tag, const Value &left, const Value &right, Node *node) {
+  if (!left.is_integer() || !right.is_integer()) {
+    EvaluationError::raise(node->get_loc(), "Bitwise operations need integer operands");
+  }
+
+  if (tag == AST_SHIFT_LEFT || tag == AST_SHIFT_RIGHT) {
+    if (right.get_kind() != VALUE_INT || right.get_ival() < 0) {
+      EvaluationError::raise(node->get_loc(), "Shift count out of range: %s", right.as_str().c_str());
+    }
+    int64_t n = int_arg(right, node->get_loc());
+    if (left.get_kind() == VALUE_INT) {
+      // fast path: an arithmetic shift, or a left shift that doesn't overflow
+      int64_t l = left.get_ival();
+      if (tag == AST_SHIFT_RIGHT) {
+        return Value(n < 64 ? l >> n : int64_t(l < 0 ? -1 : 0));
+      }
+      if (n < 64) {
+        int64_t res = int64_t(uint64_t(l) << n);
+        if ((res >> n) == l) {
+          return Value(res);
+        }
+      }
+    }
+    return tag == AST_SHIFT_LEFT ? BigInt::shift_left(left, n) : BigInt::shift_right(left, n);
+  }
+
+  if (left.get_kind() == VALUE_INT && right.get_kind() == VALUE_INT) {
+    int64_t l = left.get_ival(), r = right.get_ival();
+    switch (tag) {
+      case AST_BITAND:
+        return Value(l & r);
+      case AST_BITOR:
+        return Value(l | r);
+      default:
+        return Value(l ^ r);
+    }
+  }
+
+  // a bigint operand: the same, on two's complement bits
+  switch (tag) {
+    case AST_BITAND:
+      return BigInt::bit_and(left, right);
+    case AST_BITOR:
+      return BigInt::bit_or(left, right);
+    default:
+      return BigInt::bit_xor(left, right);
+  }
+}
+
+Value *Interpreter::lookup_variable(Node *node, Environment *env) {
+  Value *slot = env->lookup(node->get_str());
+  if (slot == nullptr) {
+    EvaluationError::raise(node->get_loc(),
+                           "%s", ("Function not defined before invoking '" + node->get_str() + "'").c_str());
+  }
+  return slot;
+}
+
+// Int index into a container, checking its type
+static int check_index(Node *node, const Value &index) {
+  if (!index.is_integer()) {
+    EvaluationError::raise(node->get_loc(), "Index must be an integer");
+  }
+  return Interpreter::int_arg(index, node->get_loc());
+}
+
+Value Interpreter::evaluate_index(Node *node, const Value &container, const Value &index) {
+  const Location &loc = node->get_loc();
+  switch (container.get_kind()) {
+    case VALUE_ARRAY:
+      return container.get_array()->get(check_index(node, index), loc);
+    case VALUE_DEQUE:
+      return container.get_deque()->get(check_index(node, index), loc);
+    case VALUE_RECORD_ARRAY:
+      return container.get_record_array()->get(check_index(node, index), loc);
+    case VALUE_BYTES:
+      return Value(container.get_bytes()->get(check_index(node, index), loc));
+    case VALUE_MAPPED_ARRAY:
+      return container.get_mapped_array()->get(check_index(node, index), loc);
+    case VALUE_STRING: {
+      String *str = container.get_string();
+      int i = check_index(node, index);
+      if (i < 0 || i >= str->strlen()) {
+        EvaluationError::raise(loc, "String index out of bound: %d", i);
+      }
+      return Value(int((unsigned char) str->data()[i]));
+    };
+    case VALUE_MAP: {
+      Value *val = container.get_map()->find(index, loc);
+      if (val == nullptr) {
+        EvaluationError::raise(loc, "%s", ("Key not found in map: " + index.as_str()).c_str());
+      }
+      return *val;
+    };
+    default:
+      EvaluationError::raise(loc, "Indexing a value that is not an array, deque, map, bytes or string");
+  }
+}
+
+Value Interpreter::store_index(Node *node, const Value &container, const Value &index, const Value &val) {
+  const Location &loc = node->get_loc();
+  switch (container.get_kind()) {
+    case VALUE_ARRAY:
+      return container.get_array()->set(check_index(node, index), val, loc);
+    case VALUE_DEQUE:
+      return container.get_deque()->set(check_index(node, index), val, loc);
+    case VALUE_RECORD_ARRAY:
+      return container.get_record_array()->set(check_index(node, index), val, loc);
+    case VALUE_BYTES:
+      if (!val.is_integer()) {
+        EvaluationError::raise(loc, "Only integers can be stored in bytes");
+      }
+      return Value(container.get_bytes()->set(check_index(node, index), int_arg(val, loc), loc));
+    case VALUE_MAPPED_ARRAY:
+      return container.get_mapped_array()->set(check_index(node, index), val, loc);
+    case VALUE_MAP:
+      container.get_map()->put(index, val, loc);
+      return val;
+    default:
+      EvaluationError::raise(loc, "Element assignment to a value that is not an array, deque, map or bytes");
+  }
+}
+
+// Evaluates the record whose field node (an AST_FIELDREF) refers to,
+// for assigning to the field.  Reading an element of an array of
+// records gathers it into a new record, so assigning to that would
+// be lost: for an element of one, the array is returned instead,
+// with the element's index in index.
+Value Interpreter::evaluate_field_owner(Node *node, Environment *env, int &index) {
+  Node *objectNode = node->get_kid(0);
+  Value object;
+  if (objectNode->get_tag() == AST_INDEX) {
+    Value container = evaluate(objectNode->get_kid(0), env);
+    Value element = evaluate(objectNode->get_kid(1), env);
+    if (container.get_kind() == VALUE_RECORD_ARRAY) {
+      index = check_index(objectNode, element);
+      return container;
+    }
+    object = evaluate_index(objectNode, container, element);
+  } else {
+    object = evaluate(objectNode, env);
+  }
+  if (object.get_kind() != VALUE_RECORD) {
+    EvaluationError::raise(node->get_loc(), "Field assignment to a value that is not a record");
+  }
+  return object;
+}
+
+// Storage of the field node refers to, in an owner found by
+// evaluate_field_owner
+Value *Interpreter::find_field(Node *node, const Value &owner, int index) {
+  if (owner.get_kind() == VALUE_RECORD_ARRAY) {
+    RecordArray *records = owner.get_record_array();
+    return records->field_at(find_field_slot(node, records->get_shape()), index, node->get_loc());
+  }
+  Record *record = owner.get_record();
+  return record->at(find_field_slot(node, record->get_shape()));
+}
+
+Value Interpreter::evaluate_update(Node *node, Environment *env) {
+  int tag = node->get_tag();
+  bool is_postfix = tag == AST_INCREMENT || tag == AST_DECREMENT;
+
+  // the right hand side is evaluated first, so that the target
+  // location can't be invalidated (e.g. by resizing its array)
+  Value rhs = is_postfix ? Value(1) : evaluate_and_check_numeric(node, env, 1);
+  int op_tag;
+  switch (tag) {
+    case AST_ADD_ASSIGN:
+    case AST_INCREMENT:
+      op_tag = AST_ADD;
+      break;
+    case AST_SUB_ASSIGN:
+    case AST_DECREMENT:
+      op_tag = AST_SUB;
+      break;
+    case AST_MULTIPLY_ASSIGN:
+      op_tag = AST_MULTIPLY;
+      break;
+    default:
+      op_tag = AST_DIVIDE;
+      break;
+  }
+
+  // find the target's storage once and update it in place
+  Node *target = node->get_kid(0);
+  Value *slot = nullptr;
+  Value object, container, index;
+  switch (target->get_tag()) {
+    case AST_VARREF:
+      slot = lookup_variable(target, env);
+      break;
+    case AST_FIELDREF: {
+      int element;
+      object = evaluate_field_owner(target, env, element);
+      slot = find_field(target, object, element);
+      break;
+    };
+    default: {
+      container = evaluate(target->get_kid(0), env);
+      index = evaluate(target->get_kid(1), env);
+      const Location &loc = target->get_loc();
+      if (container.get_kind() == VALUE_ARRAY) {
+        slot = container.get_array()->at(check_index(target, index), loc);
+      } else if (container.get_kind() == VALUE_DEQUE) {
+        slot = container.get_deque()->at(check_index(target, index), loc);
+      } else if (container.get_kind() == VALUE_MAP) {
+        slot = container.get_map()->find(index, loc);
+        if (slot == nullptr) {
+          EvaluationError::raise(loc, "%s", ("Key not found in map: " + index.as_str()).c_str());
+        }
+      }
+      break;
+    };
+  }
+
+  Value old_val = slot != nullptr ? *slot : evaluate_index(target, container, index);
+  check_numeric(old_val, node);
+  Value new_val = evaluate_arithmetic(op_tag, old_val, rhs, node);
+  if (slot != nullptr) {
+    *slot = new_val;
+  } else {
+    // elements that aren't stored as Values (bytes, arrays of records,
+    // mapped arrays)
+    store_index(target, container, index, new_val);
+  }
+  return is_postfix ? old_val : new_val;
+}
+
 Value Interpreter::evaluate_and_check_numeric(Node* node, Environment* env, int i) {
   Value result = evaluate(node->get_kid(i), env);
+  check_numeric(result, node);
+  return result;
+}
 
-  if (!result.is_numeric()) {
+void Interpreter::check_numeric(const Value &val, Node *node) {
+  if (!val.is_numeric()) {
     EvaluationError::raise(node->get_loc(), "Cannot perform arithmetic calculation on non-numeric values");
   }
+}
 
-  return result;
+Value Interpreter::evaluate_string_comparison(Node *node, const Value &left, const Value &right) {
+  int tag = node->get_tag();
+  if (!is_comparison(tag)) {
+    EvaluationError::raise(node->get_loc(), "Cannot perform arithmetic calculation on non-numeric values");
+  }
+  if (right.get_kind() != VALUE_STRING) {
+    EvaluationError::raise(node->get_loc(), "Cannot compare a string with a non-string value");
+  }
+  String *l = left.get_string(), *r = right.get_string();
+  switch (tag) {
+    case AST_ISEQUAL:
+      return Value(l->equals(r) ? 1 : 0);
+    case AST_ISNOTEQUAL:
+      return Value(l->equals(r) ? 0 : 1);
+    default:
+      return Value(comparison_holds(tag, l->compare(r)) ? 1 : 0);
+  }
+}
+
+bool Interpreter::is_comparison(int tag) {
+  return tag == AST_LESS || tag == AST_LESSEQUAL || tag == AST_GREATER ||
+         tag == AST_GREATEREQUAL || tag == AST_ISEQUAL || tag == AST_ISNOTEQUAL;
+}
+
+bool Interpreter::comparison_holds(int tag, int cmp) {
+  switch (tag) {
+    case AST_LESS:
+      return cmp < 0;
+    case AST_LESSEQUAL:
+      return cmp <= 0;
+    case AST_GREATER:
+      return cmp > 0;
+    case AST_GREATEREQUAL:
+      return cmp >= 0;
+    case AST_ISEQUAL:
+      return cmp == 0;
+    default:
+      return cmp != 0;
+  }
+}
+
+Value Interpreter::evaluate_numeric_comparison(int tag, const Value &left, const Value &right) {
+  if ((left.get_kind() == VALUE_DOUBLE && std::isnan(left.get_dval())) ||
+      (right.get_kind() == VALUE_DOUBLE && std::isnan(right.get_dval()))) {
+    // comparisons involving NaN are false, except !=
+    return Value(tag == AST_ISNOTEQUAL ? 1 : 0);
+  }
+  return Value(comparison_holds(tag, left.compare_numeric(right)) ? 1 : 0);
+}
+
+bool Interpreter::is_true(const Value &val) {
+  // only the int 0 (and the double 0.0) are false; bigints are never zero
+  if (val.get_kind() == VALUE_DOUBLE) {
+    return val.get_dval() != 0;
+  }
+  return val.get_kind() != VALUE_INT || val.get_ival() != 0;
 }
 
 std::string Interpreter::check_exists(std::string identifier, Environment* env, Node *node) {
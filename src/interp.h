@@ -1,12 +1,29 @@
 #ifndef INTERP_H
 #define INTERP_H
 
+#include <algorithm>
+#include <cmath>
 #include <set>
+#include <unordered_map>
 #include "value.h"
 #include "exceptions.h"
 #include "array.h"
 #include "string.h"
+#include "bytes.h"
+#include "map.h"
+#include "bitset.h"
+#include "deque.h"
+#include "pqueue.h"
+#include "matrix.h"
+#include "record.h"
+#include "bigint.h"
 #include "environment.h"
+#include "outbuf.h"
+#include "inbuf.h"
+#include "file.h"
+#include "mappedarray.h"
+#include "serialize.h"
+#include "csv.h"
 
 class Node;
 class Location;
@@ -14,6 +31,20 @@ class Location;
 class Interpreter {
 private:
   Node *m_ast;
+  // interned strings: string literals with the same contents
+  // evaluate to the same String object
+  std::unordered_map<std::string, Value> m_interned;
+
+  // How control leaves the statements being executed: break, continue
+  // and return set this, and the enclosing statement lists, loops and
+  // function calls stop early and reset it.
+  enum FlowStatus { FLOW_NORMAL, FLOW_BREAK, FLOW_CONTINUE, FLOW_RETURN };
+  FlowStatus m_flow;
+  Value m_return_value;
+
+  // the program's standard input and output
+  InputBuffer m_in;
+  OutputBuffer m_out;
 
 public:
   Interpreter(Node *ast_to_adopt);
@@ -23,12 +54,30 @@ public:
   Value execute();
   Value execute(Node *node, Environment *env);
 
+  // Call a user-defined or intrinsic function with the given arguments
+  Value call_function(const Value &fn, Value args[], unsigned num_args, const Location &loc);
+
+  // Return the canonical String value with the given contents
+  Value intern(const std::string &str);
+
+  // The buffers for the program's standard input and output
+  InputBuffer &get_input() { return m_in; }
+  OutputBuffer &get_output() { return m_out; }
+
+  // The value of an int used as an index, size or 32-bit element,
+  // checking that it is in range
+  static int int_arg(const Value &val, const Location &loc) {
+    if (val.get_kind() != VALUE_INT || val.get_ival() < INT32_MIN || val.get_ival() > INT32_MAX)
+      EvaluationError::raise(loc, "Integer out of range: %s", val.as_str().c_str());
+    return int(val.get_ival());
+  }
+
   // DONE: add intrinsic functions definitions
   static Value intrinsic_print(Value args[], unsigned num_args,
                                const Location &loc, Interpreter *interp) {
     if (num_args != 1)
       EvaluationError::raise(loc, "Wrong number of arguments passed to print function");
-    printf("%s", args[0].as_str().c_str());
+    interp->get_output().write_value(args[0]);
     return Value();
   }
 
@@ -36,7 +85,9 @@ public:
                                const Location &loc, Interpreter *interp) {
     if (num_args != 1)
       EvaluationError::raise(loc, "Wrong number of arguments passed to println function");
-    printf("%s\n", args[0].as_str().c_str());
+    OutputBuffer &out = interp->get_output();
+    out.write_value(args[0]);
+    out.end_line();
     return Value();
   }
 
@@ -47,15 +98,264 @@ public:
       EvaluationError::raise(loc, "readint does not take any arguments");
     }
 
-    int input_value;
-    int read_result = scanf("%d", &input_value);
+    // show any prompt before waiting for input
+    interp->get_output().flush();
 
+    Value input_value;
     // Check for read errors or unexpected input format
-    if (read_result != 1) {
+    if (!interp->get_input().read_int(input_value)) {
       EvaluationError::raise(loc, "Failed to read an integer from standard input");
     }
 
-    return Value(input_value);
+    return input_value;
+  }
+
+  // The buffer to read from: standard input, or the file given as the
+  // optional argument i
+  static InputBuffer &input_arg(Value args[], unsigned num_args, unsigned i,
+                                const char *fn_name, const Location &loc, Interpreter *interp) {
+    if (num_args <= i) {
+      // show any prompt before waiting for input
+      interp->get_output().flush();
+      return interp->get_input();
+    }
+    if (args[i].get_kind() != VALUE_FILE || args[i].get_file()->get_input() == nullptr)
+      EvaluationError::raise(loc, "Argument to %s function must be a file opened for reading", fn_name);
+    return *args[i].get_file()->get_input();
+  }
+
+  static Value intrinsic_readints(Value args[], unsigned num_args,
+                                  const Location &loc, Interpreter *interp) {
+    if (num_args != 1 && num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to readints function");
+    int n = int_arg(args[0], loc);
+    if (n < 0)
+      EvaluationError::raise(loc, "Negative count passed to readints function: %d", n);
+    InputBuffer &in = input_arg(args, num_args, 1, "readints", loc, interp);
+
+    // up to n ints, stopping early at the end of the input (so n is
+    // only a bound, and can't be trusted for the reservation)
+    std::vector<Value> values;
+    values.reserve(std::min(n, 4096));
+    Value val;
+    while (int(values.size()) < n && !in.at_end()) {
+      if (!in.read_int(val))
+        EvaluationError::raise(loc, "Failed to read an integer from input");
+      values.push_back(val);
+    }
+    return Value(new Array(values));
+  }
+
+  static Value intrinsic_readline(Value args[], unsigned num_args,
+                                  const Location &loc, Interpreter *interp) {
+    if (num_args > 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to readline function");
+    InputBuffer &in = input_arg(args, num_args, 0, "readline", loc, interp);
+    // 0 at the end of the input
+    Value line;
+    if (!in.read_line(line))
+      return Value(0);
+    return line;
+  }
+
+  static Value intrinsic_readall(Value args[], unsigned num_args,
+                                 const Location &loc, Interpreter *interp) {
+    if (num_args > 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to readall function");
+    return input_arg(args, num_args, 0, "readall", loc, interp).read_all();
+  }
+
+  // Functions for files
+  static Value file_openfile(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to openfile function");
+    if (args[0].get_kind() != VALUE_STRING || args[1].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Arguments to openfile function must be a path and a mode");
+    return File::open(args[0].get_string()->get_actual_string(), args[1].get_string()->get_actual_string(), loc);
+  }
+
+  static Value file_closefile(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to closefile function");
+    if (args[0].get_kind() != VALUE_FILE)
+      EvaluationError::raise(loc, "Argument to closefile function must be a file");
+    args[0].get_file()->close(loc);
+    return Value();
+  }
+
+  static Value file_readfile(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to readfile function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Argument to readfile function must be a path");
+    return File::read_contents(args[0].get_string()->get_actual_string(), loc);
+  }
+
+  static Value file_mapfile(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to mapfile function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Argument to mapfile function must be a path");
+    return File::map_contents(args[0].get_string()->get_actual_string(), loc);
+  }
+
+  static Value file_writefile(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to writefile function");
+    if (args[0].get_kind() == VALUE_STRING) {
+      // replace the whole file
+      File::write_contents(args[0].get_string()->get_actual_string(), args[1], loc);
+      return Value();
+    }
+    if (args[0].get_kind() != VALUE_FILE || args[0].get_file()->get_output() == nullptr)
+      EvaluationError::raise(loc, "First argument to writefile function must be a path or a file opened for writing");
+    args[0].get_file()->get_output()->write_value(args[1]);
+    args[0].get_file()->check_output(loc);
+    return Value();
+  }
+
+  // Functions for serialization
+  static Value intrinsic_serialize(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1 && num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to serialize function");
+    if (num_args == 1) {
+      Value bytes(new Bytes());
+      serialutil::serialize(args[0], bytes.get_bytes(), loc);
+      return bytes;
+    }
+    // write straight to a file
+    if (args[1].get_kind() != VALUE_FILE || args[1].get_file()->get_output() == nullptr)
+      EvaluationError::raise(loc, "Second argument to serialize function must be a file opened for writing");
+    serialutil::serialize(args[0], *args[1].get_file()->get_output(), loc);
+    args[1].get_file()->check_output(loc);
+    return Value();
+  }
+
+  static Value intrinsic_deserialize(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to deserialize function");
+    switch (args[0].get_kind()) {
+      case VALUE_BYTES: {
+        Bytes *bytes = args[0].get_bytes();
+        return serialutil::deserialize(bytes->data(), size_t(bytes->len()), loc);
+      }
+      case VALUE_STRING: {
+        // e.g., from readfile or mapfile
+        String *str = args[0].get_string();
+        return serialutil::deserialize(reinterpret_cast<const unsigned char *>(str->data()),
+                                       size_t(str->strlen()), loc);
+      }
+      default:
+        EvaluationError::raise(loc, "Argument to deserialize function must be bytes or a string");
+    }
+  }
+
+  // Functions for CSV data
+  static char csv_sep_arg(const Value &sep, const char *fn_name, const Location &loc) {
+    if (sep.get_kind() != VALUE_STRING || sep.get_string()->strlen() != 1)
+      EvaluationError::raise(loc, "Separator passed to %s function must be a single character", fn_name);
+    char c = sep.get_string()->data()[0];
+    if (c == '"' || c == '\n')
+      EvaluationError::raise(loc, "Separator passed to %s function can't be a quote or newline", fn_name);
+    return c;
+  }
+
+  static Value csv_parsecsv(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to parsecsv function");
+    return csvutil::parse_rows(args[0], csv_sep_arg(args[1], "parsecsv", loc), loc);
+  }
+
+  static Value csv_parsecsvints(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to parsecsvints function");
+    return csvutil::parse_int_columns(args[0], csv_sep_arg(args[1], "parsecsvints", loc), loc);
+  }
+
+  static Value csv_eachcsv(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to eachcsv function");
+    if (args[0].get_kind() != VALUE_FILE || args[0].get_file()->get_input() == nullptr)
+      EvaluationError::raise(loc, "First argument to eachcsv function must be a file opened for reading");
+    char sep = csv_sep_arg(args[1], "eachcsv", loc);
+    if (args[2].get_kind() != VALUE_FUNCTION && args[2].get_kind() != VALUE_INTRINSIC_FN)
+      EvaluationError::raise(loc, "Third argument to eachcsv function must be a function");
+    const Value &fn = args[2];
+    File *file = args[0].get_file();
+    // fn mustn't close the file while its buffer is in use
+    File::Reading reading(file);
+    int count = csvutil::each_row(*file->get_input(), sep, loc, [&](const Value &row) {
+      Value fn_args[1] = { row };
+      interp->call_function(fn, fn_args, 1, loc);
+    });
+    return Value(count);
+  }
+
+  // functions for numbers
+  static Value number_toint(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to toint function");
+    if (!args[0].is_numeric())
+      EvaluationError::raise(loc, "Argument to toint function must be a number");
+    if (args[0].get_kind() != VALUE_DOUBLE)
+      return args[0];
+    // truncate toward zero
+    double dval = args[0].get_dval();
+    if (!std::isfinite(dval))
+      EvaluationError::raise(loc, "Cannot convert %s to an integer", args[0].as_str().c_str());
+    if (dval > -9223372036854775808.0 && dval < 9223372036854775808.0)
+      return Value(int64_t(dval));
+    return BigInt::from_double(dval);
+  }
+
+  static Value number_tofloat(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to tofloat function");
+    if (!args[0].is_numeric())
+      EvaluationError::raise(loc, "Argument to tofloat function must be a number");
+    return Value(args[0].to_double());
+  }
+
+  // bit counts of a 64-bit int (as two's complement); clz and ctz of 0 are 64
+  static Value number_popcount(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to popcount function");
+    if (args[0].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Argument to popcount function must be a 64-bit integer");
+    return Value(__builtin_popcountll(uint64_t(args[0].get_ival())));
+  }
+
+  static Value number_clz(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to clz function");
+    if (args[0].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Argument to clz function must be a 64-bit integer");
+    uint64_t bits = uint64_t(args[0].get_ival());
+    return Value(bits == 0 ? 64 : __builtin_clzll(bits));
+  }
+
+  static Value number_ctz(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to ctz function");
+    if (args[0].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Argument to ctz function must be a 64-bit integer");
+    uint64_t bits = uint64_t(args[0].get_ival());
+    return Value(bits == 0 ? 64 : __builtin_ctzll(bits));
   }
 
   // Functions for array
@@ -72,33 +372,96 @@ public:
                                 const Location &loc, Interpreter *interp) {
     if (num_args != 1)
       EvaluationError::raise(loc, "Wrong number of arguments passed to array length function");
-    if (args[0].get_kind() != VALUE_ARRAY)
-      EvaluationError::raise(loc, "First argument to array len function must be an array");
-    return Value(args[0].get_array()->len());
+    switch (args[0].get_kind()) {
+      case VALUE_ARRAY:
+        return Value(args[0].get_array()->len());
+      case VALUE_BYTES:
+        return Value(args[0].get_bytes()->len());
+      case VALUE_MAP:
+        return Value(args[0].get_map()->len());
+      case VALUE_BITSET:
+        return Value(args[0].get_bitset()->len());
+      case VALUE_DEQUE:
+        return Value(args[0].get_deque()->len());
+      case VALUE_PQUEUE:
+        return Value(args[0].get_pqueue()->len());
+      case VALUE_RECORD_ARRAY:
+        return Value(args[0].get_record_array()->len());
+      case VALUE_MAPPED_ARRAY:
+        return Value(args[0].get_mapped_array()->len());
+      default:
+        EvaluationError::raise(loc, "First argument to array len function must be an array");
+    }
   }
 
   static Value array_get(Value args[], unsigned num_args,
                                 const Location &loc, Interpreter *interp) {
     if (num_args != 2)
       EvaluationError::raise(loc, "Wrong number of arguments passed to array get function");
-    if (args[0].get_kind() != VALUE_ARRAY)
-      EvaluationError::raise(loc, "First argument to array get function must be an array");
     if (args[1].get_kind() != VALUE_INT)
       EvaluationError::raise(loc, "Second argument to array get function must be an integer");
-    int index = args[1].get_ival();
-    return args[0].get_array()->get(index, loc);
+    int index = int_arg(args[1], loc);
+    switch (args[0].get_kind()) {
+      case VALUE_ARRAY:
+        return args[0].get_array()->get(index, loc);
+      case VALUE_DEQUE:
+        return args[0].get_deque()->get(index, loc);
+      case VALUE_RECORD_ARRAY:
+        return args[0].get_record_array()->get(index, loc);
+      case VALUE_MAPPED_ARRAY:
+        return args[0].get_mapped_array()->get(index, loc);
+      default:
+        EvaluationError::raise(loc, "First argument to array get function must be an array");
+    }
   }
 
   static Value array_set(Value args[], unsigned num_args,
                                 const Location &loc, Interpreter *interp) {
     if (num_args != 3)
       EvaluationError::raise(loc, "Wrong number of arguments passed to array set function");
-    if (args[0].get_kind() != VALUE_ARRAY)
-      EvaluationError::raise(loc, "First argument to array set function must be an array");
     if (args[1].get_kind() != VALUE_INT)
       EvaluationError::raise(loc, "Second argument to array set function must be an integer");
-    int index = args[1].get_ival();
-    return args[0].get_array()->set(index, args[2], loc);
+    int index = int_arg(args[1], loc);
+    switch (args[0].get_kind()) {
+      case VALUE_ARRAY:
+        return args[0].get_array()->set(index, args[2], loc);
+      case VALUE_DEQUE:
+        return args[0].get_deque()->set(index, args[2], loc);
+      case VALUE_RECORD_ARRAY:
+        return args[0].get_record_array()->set(index, args[2], loc);
+      case VALUE_MAPPED_ARRAY:
+        return args[0].get_mapped_array()->set(index, args[2], loc);
+      default:
+        EvaluationError::raise(loc, "First argument to array set function must be an array");
+    }
+  }
+
+  static Value array_mkarrmapped(Value args[], unsigned num_args,
+                                const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to mkarrmapped function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to mkarrmapped function must be a path");
+    return MappedArray::create(args[0].get_string()->get_actual_string(), int_arg(args[1], loc), loc);
+  }
+
+  static Value array_finisharr(Value args[], unsigned num_args,
+                                const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to finisharr function");
+    if (args[0].get_kind() != VALUE_MAPPED_ARRAY)
+      EvaluationError::raise(loc, "Argument to finisharr function must be a mapped array");
+    args[0].get_mapped_array()->finish(loc);
+    return Value();
+  }
+
+  static Value array_openarr(Value args[], unsigned num_args,
+                                const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to openarr function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Argument to openarr function must be a path");
+    return MappedArray::open(args[0].get_string()->get_actual_string(), loc);
   }
 
   static Value array_push(Value args[], unsigned num_args,
@@ -119,6 +482,36 @@ public:
     return args[0].get_array()->pop(loc);
   }
 
+  static Value array_sort(Value args[], unsigned num_args,
+                                const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to array sort function");
+    if (args[0].get_kind() != VALUE_ARRAY)
+      EvaluationError::raise(loc, "First argument to array sort function must be an array");
+    args[0].get_array()->sort(loc);
+    return args[0];
+  }
+
+  static Value array_sortby(Value args[], unsigned num_args,
+                                const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to array sortby function");
+    if (args[0].get_kind() != VALUE_ARRAY)
+      EvaluationError::raise(loc, "First argument to array sortby function must be an array");
+    if (args[1].get_kind() != VALUE_FUNCTION && args[1].get_kind() != VALUE_INTRINSIC_FN)
+      EvaluationError::raise(loc, "Second argument to array sortby function must be a function");
+    // the function is called as fn(a, b), and returns nonzero if a comes before b
+    const Value &fn = args[1];
+    args[0].get_array()->sort_by([&](const Value &a, const Value &b) {
+      Value fn_args[2] = { a, b };
+      Value result = interp->call_function(fn, fn_args, 2, loc);
+      if (result.get_kind() != VALUE_INT)
+        EvaluationError::raise(loc, "Comparison function passed to sortby must return an integer");
+      return result.get_ival() != 0;
+    });
+    return args[0];
+  }
+
   // functions for string
   static Value string_substr(Value args[], unsigned num_args,
                                const Location &loc, Interpreter *interp) {
@@ -130,8 +523,8 @@ public:
       EvaluationError::raise(loc, "Second argument to string substr function must be an integer");
     if (args[2].get_kind() != VALUE_INT)
       EvaluationError::raise(loc, "Third argument to string substr function must be an integer");
-    int start = args[1].get_ival();
-    int end = args[2].get_ival();
+    int start = int_arg(args[1], loc);
+    int end = int_arg(args[2], loc);
     return args[0].get_string()->substr(start, end, loc);
   }
 
@@ -155,13 +548,565 @@ public:
     return Value(args[0].get_string()->strlen());
   }
 
+  static Value string_strfind(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2 && num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to string strfind function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to string strfind function must be a string");
+    if (args[1].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Second argument to string strfind function must be a string");
+    int start = 0;
+    if (num_args == 3) {
+      if (args[2].get_kind() != VALUE_INT)
+        EvaluationError::raise(loc, "Third argument to string strfind function must be an integer");
+      start = int_arg(args[2], loc);
+    }
+    return Value(args[0].get_string()->find(args[1].get_string(), start));
+  }
+
+  static Value string_strcount(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to string strcount function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to string strcount function must be a string");
+    if (args[1].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Second argument to string strcount function must be a string");
+    if (args[1].get_string()->strlen() == 0)
+      EvaluationError::raise(loc, "Cannot count occurrences of an empty string");
+    return Value(args[0].get_string()->count(args[1].get_string()));
+  }
+
+  static Value string_split(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to string split function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to string split function must be a string");
+    if (args[1].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "Second argument to string split function must be a string");
+    if (args[1].get_string()->strlen() == 0)
+      EvaluationError::raise(loc, "Cannot split a string on an empty separator");
+    return args[0].get_string()->split(args[1].get_string());
+  }
+
+  static Value string_intern(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to string intern function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to string intern function must be a string");
+    return interp->intern(args[0].get_string()->get_actual_string());
+  }
+
+  // functions for bytes
+  static Value bytes_mkbytes(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args > 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bytes mkbytes function");
+    int size = 0;
+    if (num_args == 1) {
+      if (args[0].get_kind() != VALUE_INT)
+        EvaluationError::raise(loc, "First argument to bytes mkbytes function must be an integer");
+      size = int_arg(args[0], loc);
+      if (size < 0)
+        EvaluationError::raise(loc, "Negative size passed to bytes mkbytes function");
+    }
+    return Value(new Bytes(size));
+  }
+
+  static Value bytes_tobytes(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bytes tobytes function");
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to bytes tobytes function must be a string");
+    String *str = args[0].get_string();
+    return Value(new Bytes(str->data(), str->strlen()));
+  }
+
+  static Value bytes_bytestr(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bytes bytestr function");
+    if (args[0].get_kind() != VALUE_BYTES)
+      EvaluationError::raise(loc, "First argument to bytes bytestr function must be bytes");
+    return Value(new String(args[0].get_bytes()->get_actual_string()));
+  }
+
+  static Value bytes_byteat(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bytes byteat function");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to bytes byteat function must be an integer");
+    int index = int_arg(args[1], loc);
+    if (args[0].get_kind() == VALUE_BYTES)
+      return Value(args[0].get_bytes()->get(index, loc));
+    if (args[0].get_kind() != VALUE_STRING)
+      EvaluationError::raise(loc, "First argument to bytes byteat function must be bytes or a string");
+    String *str = args[0].get_string();
+    if (index < 0 || index >= str->strlen())
+      EvaluationError::raise(loc, "String index out of bound: %d", index);
+    return Value(int((unsigned char) str->data()[index]));
+  }
+
+  static Value bytes_setbyte(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bytes setbyte function");
+    if (args[0].get_kind() != VALUE_BYTES)
+      EvaluationError::raise(loc, "First argument to bytes setbyte function must be bytes");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to bytes setbyte function must be an integer");
+    if (args[2].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Third argument to bytes setbyte function must be an integer");
+    return Value(args[0].get_bytes()->set(int_arg(args[1], loc), int_arg(args[2], loc), loc));
+  }
+
+  static Value bytes_bappend(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bytes bappend function");
+    if (args[0].get_kind() != VALUE_BYTES)
+      EvaluationError::raise(loc, "First argument to bytes bappend function must be bytes");
+    Bytes *bytes = args[0].get_bytes();
+    switch (args[1].get_kind()) {
+      case VALUE_INT:
+        bytes->append_byte(int_arg(args[1], loc), loc);
+        break;
+      case VALUE_STRING:
+        bytes->append(args[1].get_string()->data(), args[1].get_string()->strlen());
+        break;
+      case VALUE_BYTES: {
+        // copy first, since a buffer may be appended to itself
+        std::string other = args[1].get_bytes()->get_actual_string();
+        bytes->append(other.data(), other.size());
+        break;
+      }
+      default:
+        EvaluationError::raise(loc, "Second argument to bytes bappend function must be a byte, string, or bytes");
+    }
+    return args[0];
+  }
+  // functions for map
+  static Value map_mkmap(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 0)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to map mkmap function");
+    return Value(new Map());
+  }
+
+  static Value map_mget(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2 && num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to map mget function");
+    if (args[0].get_kind() != VALUE_MAP)
+      EvaluationError::raise(loc, "First argument to map mget function must be a map");
+    Value *val = args[0].get_map()->find(args[1], loc);
+    if (val != nullptr)
+      return *val;
+    // the optional third argument is the default value for a missing key
+    if (num_args == 3)
+      return args[2];
+    EvaluationError::raise(loc, "%s", ("Key not found in map: " + args[1].as_str()).c_str());
+  }
+
+  static Value map_mput(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to map mput function");
+    if (args[0].get_kind() != VALUE_MAP)
+      EvaluationError::raise(loc, "First argument to map mput function must be a map");
+    args[0].get_map()->put(args[1], args[2], loc);
+    return args[2];
+  }
+
+  static Value map_mhas(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to map mhas function");
+    if (args[0].get_kind() != VALUE_MAP)
+      EvaluationError::raise(loc, "First argument to map mhas function must be a map");
+    return Value(args[0].get_map()->find(args[1], loc) != nullptr ? 1 : 0);
+  }
+
+  static Value map_mdel(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to map mdel function");
+    if (args[0].get_kind() != VALUE_MAP)
+      EvaluationError::raise(loc, "First argument to map mdel function must be a map");
+    return Value(args[0].get_map()->remove(args[1], loc) ? 1 : 0);
+  }
+
+  static Value map_mkeys(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to map mkeys function");
+    if (args[0].get_kind() != VALUE_MAP)
+      EvaluationError::raise(loc, "First argument to map mkeys function must be a map");
+    return args[0].get_map()->keys();
+  }
+
+  // functions for bitset
+  static Value bitset_mkbitset(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args > 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset mkbitset function");
+    int nbits = 0;
+    if (num_args == 1) {
+      if (args[0].get_kind() != VALUE_INT)
+        EvaluationError::raise(loc, "First argument to bitset mkbitset function must be an integer");
+      nbits = int_arg(args[0], loc);
+      if (nbits < 0)
+        EvaluationError::raise(loc, "Negative size passed to bitset mkbitset function");
+    }
+    return Value(new Bitset(nbits));
+  }
+
+  static Value bitset_bset(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset bset function");
+    if (args[0].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "First argument to bitset bset function must be a bitset");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to bitset bset function must be an integer");
+    args[0].get_bitset()->set(int_arg(args[1], loc), loc);
+    return args[0];
+  }
+
+  static Value bitset_bclear(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset bclear function");
+    if (args[0].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "First argument to bitset bclear function must be a bitset");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to bitset bclear function must be an integer");
+    args[0].get_bitset()->clear(int_arg(args[1], loc), loc);
+    return args[0];
+  }
+
+  static Value bitset_btest(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset btest function");
+    if (args[0].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "First argument to bitset btest function must be a bitset");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to bitset btest function must be an integer");
+    return Value(args[0].get_bitset()->test(int_arg(args[1], loc), loc) ? 1 : 0);
+  }
+
+  static Value bitset_bcount(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset bcount function");
+    if (args[0].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "First argument to bitset bcount function must be a bitset");
+    return Value(args[0].get_bitset()->count());
+  }
+
+  static Value bitset_bunion(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset bunion function");
+    if (args[0].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "First argument to bitset bunion function must be a bitset");
+    if (args[1].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "Second argument to bitset bunion function must be a bitset");
+    args[0].get_bitset()->unite(args[1].get_bitset());
+    return args[0];
+  }
+
+  static Value bitset_bintersect(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to bitset bintersect function");
+    if (args[0].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "First argument to bitset bintersect function must be a bitset");
+    if (args[1].get_kind() != VALUE_BITSET)
+      EvaluationError::raise(loc, "Second argument to bitset bintersect function must be a bitset");
+    args[0].get_bitset()->intersect(args[1].get_bitset());
+    return args[0];
+  }
+
+  // functions for deque
+  static Value deque_mkdeque(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    std::vector <Value> values;
+    for(unsigned i=0; i<num_args; i++){
+      values.push_back(args[i]);
+    }
+    return Value(new Deque(values));
+  }
+
+  static Value deque_pushfront(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to deque pushfront function");
+    if (args[0].get_kind() != VALUE_DEQUE)
+      EvaluationError::raise(loc, "First argument to deque pushfront function must be a deque");
+    return args[0].get_deque()->push_front(args[1]);
+  }
+
+  static Value deque_pushback(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to deque pushback function");
+    if (args[0].get_kind() != VALUE_DEQUE)
+      EvaluationError::raise(loc, "First argument to deque pushback function must be a deque");
+    return args[0].get_deque()->push_back(args[1]);
+  }
+
+  static Value deque_popfront(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to deque popfront function");
+    if (args[0].get_kind() != VALUE_DEQUE)
+      EvaluationError::raise(loc, "First argument to deque popfront function must be a deque");
+    return args[0].get_deque()->pop_front(loc);
+  }
+
+  static Value deque_popback(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to deque popback function");
+    if (args[0].get_kind() != VALUE_DEQUE)
+      EvaluationError::raise(loc, "First argument to deque popback function must be a deque");
+    return args[0].get_deque()->pop_back(loc);
+  }
+
+  // functions for priority queue
+  static Value pqueue_mkpq(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 0)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to priority queue mkpq function");
+    return Value(new PriorityQueue());
+  }
+
+  static Value pqueue_pqpush(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to priority queue pqpush function");
+    if (args[0].get_kind() != VALUE_PQUEUE)
+      EvaluationError::raise(loc, "First argument to priority queue pqpush function must be a priority queue");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to priority queue pqpush function must be an integer");
+    args[0].get_pqueue()->push(args[1].get_ival(), args[2]);
+    return args[2];
+  }
+
+  static Value pqueue_pqpop(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to priority queue pqpop function");
+    if (args[0].get_kind() != VALUE_PQUEUE)
+      EvaluationError::raise(loc, "First argument to priority queue pqpop function must be a priority queue");
+    return args[0].get_pqueue()->pop(loc);
+  }
+
+  static Value pqueue_pqpeek(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to priority queue pqpeek function");
+    if (args[0].get_kind() != VALUE_PQUEUE)
+      EvaluationError::raise(loc, "First argument to priority queue pqpeek function must be a priority queue");
+    return args[0].get_pqueue()->peek(loc);
+  }
+
+  static Value pqueue_pqlen(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to priority queue pqlen function");
+    if (args[0].get_kind() != VALUE_PQUEUE)
+      EvaluationError::raise(loc, "First argument to priority queue pqlen function must be a priority queue");
+    return Value(args[0].get_pqueue()->len());
+  }
+
+  // functions for matrix
+  static Value matrix_mkmat(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2 && num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix mkmat function");
+    if (args[0].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "First argument to matrix mkmat function must be an integer");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to matrix mkmat function must be an integer");
+    int fill = 0;
+    if (num_args == 3) {
+      if (args[2].get_kind() != VALUE_INT)
+        EvaluationError::raise(loc, "Third argument to matrix mkmat function must be an integer");
+      fill = int_arg(args[2], loc);
+    }
+    if (int_arg(args[0], loc) < 0 || int_arg(args[1], loc) < 0)
+      EvaluationError::raise(loc, "Negative dimension passed to matrix mkmat function");
+    return Value(new Matrix(int_arg(args[0], loc), int_arg(args[1], loc), fill));
+  }
+
+  static Value matrix_matget(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 3)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matget function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matget function must be a matrix");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to matrix matget function must be an integer");
+    if (args[2].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Third argument to matrix matget function must be an integer");
+    return Value(args[0].get_matrix()->get(int_arg(args[1], loc), int_arg(args[2], loc), loc));
+  }
+
+  static Value matrix_matset(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 4)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matset function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matset function must be a matrix");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to matrix matset function must be an integer");
+    if (args[2].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Third argument to matrix matset function must be an integer");
+    if (args[3].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Fourth argument to matrix matset function must be an integer");
+    return Value(args[0].get_matrix()->set(int_arg(args[1], loc), int_arg(args[2], loc), int_arg(args[3], loc), loc));
+  }
+
+  static Value matrix_matrows(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matrows function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matrows function must be a matrix");
+    return Value(args[0].get_matrix()->rows());
+  }
+
+  static Value matrix_matcols(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matcols function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matcols function must be a matrix");
+    return Value(args[0].get_matrix()->cols());
+  }
+
+  static Value matrix_matrow(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matrow function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matrow function must be a matrix");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to matrix matrow function must be an integer");
+    return args[0].get_matrix()->row(int_arg(args[1], loc), loc);
+  }
+
+  static Value matrix_matcol(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matcol function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matcol function must be a matrix");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to matrix matcol function must be an integer");
+    return args[0].get_matrix()->col(int_arg(args[1], loc), loc);
+  }
+
+  static Value matrix_transpose(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 1)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix transpose function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix transpose function must be a matrix");
+    return args[0].get_matrix()->transpose();
+  }
+
+  static Value matrix_matmul(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matmul function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matmul function must be a matrix");
+    if (args[1].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "Second argument to matrix matmul function must be a matrix");
+    return Matrix::multiply(args[0].get_matrix(), args[1].get_matrix(), loc);
+  }
+
+  static Value matrix_matadd(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matadd function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matadd function must be a matrix");
+    if (args[1].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "Second argument to matrix matadd function must be a matrix");
+    return Matrix::elementwise(args[0].get_matrix(), args[1].get_matrix(), Matrix::ELEMENTWISE_ADD, loc);
+  }
+
+  static Value matrix_matsub(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matsub function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matsub function must be a matrix");
+    if (args[1].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "Second argument to matrix matsub function must be a matrix");
+    return Matrix::elementwise(args[0].get_matrix(), args[1].get_matrix(), Matrix::ELEMENTWISE_SUB, loc);
+  }
+
+  static Value matrix_matemul(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to matrix matemul function");
+    if (args[0].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "First argument to matrix matemul function must be a matrix");
+    if (args[1].get_kind() != VALUE_MATRIX)
+      EvaluationError::raise(loc, "Second argument to matrix matemul function must be a matrix");
+    return Matrix::elementwise(args[0].get_matrix(), args[1].get_matrix(), Matrix::ELEMENTWISE_MUL, loc);
+  }
+
+  // functions for record
+  static Value record_soa(Value args[], unsigned num_args,
+                               const Location &loc, Interpreter *interp) {
+    if (num_args != 2)
+      EvaluationError::raise(loc, "Wrong number of arguments passed to record soa function");
+    if (args[0].get_kind() != VALUE_SHAPE)
+      EvaluationError::raise(loc, "First argument to record soa function must be a record type");
+    if (args[1].get_kind() != VALUE_INT)
+      EvaluationError::raise(loc, "Second argument to record soa function must be an integer");
+    if (int_arg(args[1], loc) < 0)
+      EvaluationError::raise(loc, "Negative size passed to record soa function");
+    return Value(new RecordArray(args[0].get_shape(), int_arg(args[1], loc)));
+  }
 
 private:
   // DONE: private member functions
   Value evaluate(Node *node, Environment *env);
   void analyzeHelper(Node *node, std::set<std::string> &definedVariables);
   Value create_function(Node* node, Environment* env);
+  Value create_record(Node* node, Environment* env);
+  int find_field_slot(Node *node, Shape *shape);
   Value evaluate_and_check_numeric(Node *node, Environment *env, int i);
+  Value evaluate_arithmetic(int tag, const Value &left, const Value &right, Node *node);
+  Value evaluate_bitwise(int tag, const Value &left, const Value &right, Node *node);
+  Value *lookup_variable(Node *node, Environment *env);
+  Value evaluate_index(Node *node, const Value &container, const Value &index);
+  Value store_index(Node *node, const Value &container, const Value &index, const Value &val);
+  Value evaluate_field_owner(Node *node, Environment *env, int &index);
+  Value *find_field(Node *node, const Value &owner, int index);
+  Value evaluate_update(Node *node, Environment *env);
+  Value evaluate_for_range(Node *node, Environment *env);
+  Value evaluate_for_each(Node *node, Environment *env);
+  bool leave_loop();
+  void check_numeric(const Value &val, Node *node);
+  Value evaluate_string_comparison(Node *node, const Value &left, const Value &right);
+  static bool is_comparison(int tag);
+  static bool comparison_holds(int tag, int cmp);
+  Value evaluate_numeric_comparison(int tag, const Value &left, const Value &right);
+  static bool is_true(const Value &val);
   std::string check_exists(std::string identifier, Environment* env, Node *node);
 };
 
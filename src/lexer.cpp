@@ -1,8 +1,11 @@
 #include <map>
 #include <cassert>
-#include <cctype>
+#include <cstring>
 #include <string>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "cpputil.h"
+#include "inbuf.h"
 #include "token.h"
 #include "exceptions.h"
 #include "lexer.h"
@@ -11,219 +14,391 @@
 // Lexer implementation
 ////////////////////////////////////////////////////////////////////////
 
+namespace {
+
+// Character classes, looked up in a table rather than with <cctype>
+enum {
+  CC_SPACE = 1,
+  CC_ALPHA = 2,
+  CC_DIGIT = 4,
+};
+
+struct CharClasses {
+  unsigned char bits[256];
+
+  CharClasses() {
+    memset(bits, 0, sizeof(bits));
+    for (const char *p = " \t\n\v\f\r"; *p != '\0'; p++) {
+      bits[(unsigned char) *p] = CC_SPACE;
+    }
+    for (int c = 'a'; c <= 'z'; c++) {
+      bits[c] = CC_ALPHA;
+      bits[c - 'a' + 'A'] = CC_ALPHA;
+    }
+    for (int c = '0'; c <= '9'; c++) {
+      bits[c] = CC_DIGIT;
+    }
+  }
+};
+
+const CharClasses CHAR_CLASSES;
+
+inline bool has_class(char c, int classes) {
+  return (CHAR_CLASSES.bits[(unsigned char) c] & classes) != 0;
+}
+
+struct Keyword {
+  const char *name;
+  TokenKind kind;
+};
+
+const Keyword KEYWORDS[] = {
+  { "var", TOK_VAR },
+  // A2 DONE: add cases for control flow and function
+  { "if", TOK_IF },
+  { "else", TOK_ELSE },
+  { "while", TOK_WHILE },
+  { "function", TOK_FUNCTION },
+  { "record", TOK_RECORD },
+  { "for", TOK_FOR },
+  { "in", TOK_IN },
+  { "break", TOK_BREAK },
+  { "continue", TOK_CONTINUE },
+  { "return", TOK_RETURN },
+  { "switch", TOK_SWITCH },
+  { "case", TOK_CASE },
+  { "default", TOK_DEFAULT },
+};
+
+}
+
 Lexer::Lexer(FILE *in, const std::string &filename)
   : m_in(in)
+  , m_pos(nullptr)
+  , m_end(nullptr)
+  , m_lookahead_head(0)
+  , m_lookahead_count(0)
   , m_filename(filename)
   , m_line(1)
-  , m_col(1)
-  , m_eof(false) {
+  , m_line_start(nullptr) {
+  load_source();
 }
 
 Lexer::~Lexer() {
-  // delete any cached lookahead tokens
-  for (auto i = m_lookahead.begin(); i != m_lookahead.end(); ++i) {
-    delete *i;
-  }
   fclose(m_in);
 }
 
-Node *Lexer::next() {
+void Lexer::load_source() {
+  int fd = fileno(m_in);
+  struct stat st;
+  off_t offset = lseek(fd, 0, SEEK_CUR);
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && offset >= 0 && offset < st.st_size) {
+    m_source = map_input_file(fd, size_t(st.st_size));
+    if (m_source) {
+      m_pos = m_source.get() + offset;
+      m_end = m_source.get() + st.st_size;
+      lseek(fd, 0, SEEK_END);
+    }
+  }
+  if (!m_source) {
+    // read everything, e.g. from a pipe or terminal
+    std::string *text = new std::string;
+    char block[64 * 1024];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), m_in)) > 0) {
+      text->append(block, n);
+    }
+    m_source = std::shared_ptr<const char>(text->data(), [text](const char *) { delete text; });
+    m_pos = text->data();
+    m_end = text->data() + text->size();
+  }
+  m_line_start = m_pos;
+}
+
+Token Lexer::next() {
   fill(1);
-  if (m_lookahead.empty()) {
+  if (m_lookahead_count == 0) {
     SyntaxError::raise(get_current_loc(), "Unexpected end of input");
   }
-  Node *tok = m_lookahead.front();
-  m_lookahead.pop_front();
+  Token tok = m_lookahead[m_lookahead_head];
+  m_lookahead_head = (m_lookahead_head + 1) % LOOKAHEAD_MAX;
+  m_lookahead_count--;
   return tok;
 }
 
-Node *Lexer::peek(int how_many) {
+const Token *Lexer::peek(int how_many) {
   // try to get as many lookahead tokens as required
   fill(how_many);
 
   // if there aren't enough lookahead tokens,
   // then the input ended before the token we want
-  if (int(m_lookahead.size()) < how_many) {
+  if (m_lookahead_count < how_many) {
     return nullptr;
   }
 
-  // return the pointer to the Node representing the token
-  return m_lookahead.at(how_many - 1);
+  return &m_lookahead[(m_lookahead_head + how_many - 1) % LOOKAHEAD_MAX];
+}
+
+Location Lexer::get_loc(const Token &tok) const {
+  return Location(m_filename, int(tok.line), int(tok.col));
 }
 
 Location Lexer::get_current_loc() const {
-  return Location(m_filename, m_line, m_col);
+  return Location(m_filename, m_line, column(m_pos));
 }
 
-// Read the next character of input, returning -1 (and setting m_eof to true)
-// if the end of input has been reached.
+// Read the next character of input, returning -1 if the end of input
+// has been reached.
 int Lexer::read() {
-  if (m_eof) {
+  if (m_pos == m_end) {
     return -1;
   }
-  int c = fgetc(m_in);
-  if (c < 0) {
-    m_eof = true;
-  } else if (c == '\n') {
-    m_col = 1;
-    m_line++;
-  } else {
-    m_col++;
-  }
-  return c;
-}
-
-// "Unread" a character.  Useful for when reading a character indicates
-// that the current token has ended and the next one has begun.
-void Lexer::unread(int c) {
-  ungetc(c, m_in);
+  char c = *m_pos++;
   if (c == '\n') {
-    m_line--;
-    m_col = 99;
-  } else {
-    m_col--;
+    m_line++;
+    m_line_start = m_pos;
   }
+  return (unsigned char) c;
 }
 
 void Lexer::fill(int how_many) {
-  assert(how_many > 0);
-  while (!m_eof && int(m_lookahead.size()) < how_many) {
-    Node *tok = read_token();
-    if (tok != nullptr) {
-      m_lookahead.push_back(tok);
-    }
+  assert(how_many > 0 && how_many < LOOKAHEAD_MAX);
+  Token tok;
+  while (m_lookahead_count < how_many && read_token(tok)) {
+    push_token(tok);
   }
 }
 
-Node *Lexer::read_token() {
-  int c, line = -1, col = -1;
+void Lexer::push_token(const Token &tok) {
+  assert(m_lookahead_count < LOOKAHEAD_MAX);
+  m_lookahead[(m_lookahead_head + m_lookahead_count) % LOOKAHEAD_MAX] = tok;
+  m_lookahead_count++;
+}
 
-  // skip whitespace characters until a non-whitespace character is read
-  for (;;) {
-    line = m_line;
-    col = m_col;
-    c = read();
-    if (c < 0 || !isspace(c)) {
-      break;
+// Scan the next token into tok, returning false at the end of input.
+bool Lexer::read_token(Token &tok) {
+  // skip whitespace characters
+  while (m_pos < m_end && has_class(*m_pos, CC_SPACE)) {
+    if (*m_pos == '\n') {
+      m_line++;
+      m_line_start = m_pos + 1;
     }
+    m_pos++;
   }
 
-  if (c < 0) {
+  if (m_pos == m_end) {
     // reached end of file
-    return nullptr;
+    return false;
   }
 
-  std::string lexeme;
-  lexeme.push_back(char(c));
-
-  if (isalpha(c)) {
-    Node *tok = read_continued_token(TOK_IDENTIFIER, lexeme, line, col, isalnum);
-    // DONE: use set_tag to change the token kind if it's actually a keyword
-    if (tok -> get_str() == "var") {
-        tok->set_tag(TOK_VAR);
-
-    // A2 DONE: add cases for control flow and function
-    } else if (tok -> get_str() == "if") {
-        tok -> set_tag(TOK_IF);
-    } else if (tok -> get_str() == "else") {
-        tok -> set_tag(TOK_ELSE);
-    } else if (tok -> get_str() == "while") {
-        tok -> set_tag(TOK_WHILE);
-    } else if (tok -> get_str() == "function") {
-        tok->set_tag(TOK_FUNCTION);
-    }
-    return tok;
-  } else if (isdigit(c)) {
-    return read_continued_token(TOK_INTEGER_LITERAL, lexeme, line, col, isdigit);
+  const char *start = m_pos;
+  int line = m_line, col = column(start);
+  char c = *m_pos++;
+
+  if (has_class(c, CC_ALPHA)) {
+    tok = identifier_create(start, line, col);
+  } else if (has_class(c, CC_DIGIT)) {
+    tok = number_create(start, line, col);
   } else {
     switch (c) {
     case '+':
-      return token_create(TOK_PLUS, lexeme, line, col);
+      tok = try_two_character_token('+', '=', '+', TOK_PLUS, TOK_PLUS_ASSIGN, TOK_INCREMENT, line, col);
+      break;
     case '-':
-      return token_create(TOK_MINUS, lexeme, line, col);
+      tok = try_two_character_token('-', '=', '-', TOK_MINUS, TOK_MINUS_ASSIGN, TOK_DECREMENT, line, col);
+      break;
     case '*':
-      return token_create(TOK_TIMES, lexeme, line, col);
+      tok = try_two_character_token('*', '=', TOK_TIMES, TOK_TIMES_ASSIGN, line, col);
+      break;
     case '/':
-      return token_create(TOK_DIVIDE, lexeme, line, col);
+      tok = try_two_character_token('/', '=', TOK_DIVIDE, TOK_DIVIDE_ASSIGN, line, col);
+      break;
     case '(':
-      return token_create(TOK_LPAREN, lexeme, line, col);
+      tok = token_create(TOK_LPAREN, start, m_pos, line, col);
+      break;
     case ')':
-      return token_create(TOK_RPAREN, lexeme, line, col);
+      tok = token_create(TOK_RPAREN, start, m_pos, line, col);
+      break;
     case ';':
-      return token_create(TOK_SEMICOLON, lexeme, line, col);
+      tok = token_create(TOK_SEMICOLON, start, m_pos, line, col);
+      break;
     // DONE: add cases for other kinds of tokens
     case '=':
-      return try_two_character_token('=', '=', TOK_ASSIGN, TOK_IS_EQUAL, line, col);
+      tok = try_two_character_token('=', '=', TOK_ASSIGN, TOK_IS_EQUAL, line, col);
+      break;
     case '<':
-      return try_two_character_token('<', '=', TOK_LESS, TOK_LESS_EQUAL, line, col);
+      tok = try_two_character_token('<', '=', '<', TOK_LESS, TOK_LESS_EQUAL, TOK_SHIFT_LEFT, line, col);
+      break;
     case '>':
-      return try_two_character_token('>', '=', TOK_GREATER, TOK_GREATER_EQUAL, line, col);
+      tok = try_two_character_token('>', '=', '>', TOK_GREATER, TOK_GREATER_EQUAL, TOK_SHIFT_RIGHT, line, col);
+      break;
     case '&':
-      return try_two_character_token('&', '&', ERROR, TOK_AND, line, col);
+      tok = try_two_character_token('&', '&', TOK_BITAND, TOK_AND, line, col);
+      break;
     case '|':
-      return try_two_character_token('|', '|', ERROR, TOK_OR, line, col);
+      tok = try_two_character_token('|', '|', TOK_BITOR, TOK_OR, line, col);
+      break;
+    case '^':
+      tok = token_create(TOK_BITXOR, start, m_pos, line, col);
+      break;
+    case '%':
+      tok = token_create(TOK_MOD, start, m_pos, line, col);
+      break;
     case '!':
-      return try_two_character_token('!', '=', ERROR, TOK_NOT_EQUAL, line, col);
+      tok = try_two_character_token('!', '=', ERROR, TOK_NOT_EQUAL, line, col);
+      break;
     // A2 DONE: add cases for grouping and sequencing tokens
     case '{':
-      return token_create(TOK_LBRACE, lexeme, line, col);
+      tok = token_create(TOK_LBRACE, start, m_pos, line, col);
+      break;
     case '}':
-      return token_create(TOK_RBRACE, lexeme, line, col);
+      tok = token_create(TOK_RBRACE, start, m_pos, line, col);
+      break;
     case ',':
-      return token_create(TOK_COMMA, lexeme, line, col);
+      tok = token_create(TOK_COMMA, start, m_pos, line, col);
+      break;
+    case ':':
+      tok = token_create(TOK_COLON, start, m_pos, line, col);
+      break;
+    case '.':
+      tok = try_two_character_token('.', '.', TOK_DOT, TOK_DOTDOT, line, col);
+      break;
+    case '[':
+      tok = token_create(TOK_LBRACKET, start, m_pos, line, col);
+      break;
+    case ']':
+      tok = token_create(TOK_RBRACKET, start, m_pos, line, col);
+      break;
     case '"':
-      return string_create(lexeme, line, col);
+      tok = string_create(line, col);
+      break;
     default:
       SyntaxError::raise(get_current_loc(), "Unrecognized character '%c'", c);
     }
   }
+  return true;
 }
 
-// Helper function to create a Node object to represent a token.
-Node *Lexer::token_create(enum TokenKind kind, const std::string &lexeme, int line, int col) {
-  Node *token = new Node(kind, lexeme);
-  Location source_info(m_filename, line, col);
-  token->set_loc(source_info);
-  return token;
+// Create a token whose lexeme is the text from start to end.
+Token Lexer::token_create(enum TokenKind kind, const char *start, const char *end, int line, int col) {
+  Token tok;
+  tok.start = start;
+  tok.len = uint32_t(end - start);
+  tok.kind = uint32_t(kind);
+  tok.line = uint32_t(line);
+  tok.col = uint32_t(col);
+  return tok;
 }
 
-// Read the continuation of a (possibly) multi-character token, such as
-// an identifier or integer literal.  pred is a pointer to a predicate
-// function to determine which characters are valid continuations.
-Node *Lexer::read_continued_token(enum TokenKind kind, const std::string &lexeme_start, int line, int col, int (*pred)(int)) {
-  std::string lexeme(lexeme_start);
-  for (;;) {
-    int c = read();
-    if (c >= 0 && pred(c)) {
-      // token has finished
-      lexeme.push_back(char(c));
-    } else {
-      if (c >= 0) {
-        unread(c);
-      }
-      return token_create(kind, lexeme, line, col);
+// Read the rest of an identifier or keyword, which starts at start.
+Token Lexer::identifier_create(const char *start, int line, int col) {
+  while (m_pos < m_end && has_class(*m_pos, CC_ALPHA | CC_DIGIT)) {
+    m_pos++;
+  }
+  // DONE: use the keyword's token kind if it's actually a keyword
+  size_t len = size_t(m_pos - start);
+  TokenKind kind = TOK_IDENTIFIER;
+  for (const Keyword &keyword : KEYWORDS) {
+    if (keyword.name[0] == *start && strlen(keyword.name) == len && memcmp(keyword.name, start, len) == 0) {
+      kind = keyword.kind;
+      break;
     }
   }
+  return token_create(kind, start, m_pos, line, col);
 }
 
 // DONE: implement additional member functions if necessary
-Node *Lexer::try_two_character_token(char first, char second, TokenKind oneCharKind, TokenKind twoCharKind, int line, int col) {
-  std::string lexeme(1, first);
-  int next_c = read();
-  if (next_c == second) {
-    lexeme.push_back(char(next_c));
-    return token_create(twoCharKind, lexeme, line, col);
+// first has just been read.
+Token Lexer::try_two_character_token(char first, char second, TokenKind oneCharKind, TokenKind twoCharKind, int line, int col) {
+  const char *start = m_pos - 1;
+  if (m_pos < m_end && *m_pos == second) {
+    m_pos++;
+    return token_create(twoCharKind, start, m_pos, line, col);
   } else if (oneCharKind == ERROR) {
     SyntaxError::raise(get_current_loc(), "Unrecognized character '%c'", first);
   } else {
-    unread(next_c);
-    return token_create(oneCharKind, lexeme, line, col);
+    return token_create(oneCharKind, start, m_pos, line, col);
+  }
+}
+
+// Like the above, but with two possible second characters, e.g. "+", "+=" and "++".
+Token Lexer::try_two_character_token(char first, char second, char other_second, TokenKind oneCharKind,
+                                     TokenKind twoCharKind, TokenKind otherTwoCharKind, int line, int col) {
+  const char *start = m_pos - 1;
+  if (m_pos < m_end && (*m_pos == second || *m_pos == other_second)) {
+    TokenKind kind = *m_pos == second ? twoCharKind : otherTwoCharKind;
+    m_pos++;
+    return token_create(kind, start, m_pos, line, col);
+  } else {
+    return token_create(oneCharKind, start, m_pos, line, col);
+  }
+}
+
+// Read an integer or float literal, which starts at start.  A float
+// literal has a fraction and/or an exponent: 1.5, 1., 2e10, 2.5e-3.
+// Since "1..5" is a range, an integer followed by ".." is returned
+// with the ".." token queued after it.
+Token Lexer::number_create(const char *start, int line, int col) {
+  const char *p = m_pos;
+  bool is_float = false;
+  while (p < m_end && has_class(*p, CC_DIGIT)) {
+    p++;
+  }
+
+  if (p < m_end && *p == '.') {
+    if (p + 1 < m_end && p[1] == '.') {
+      push_token(token_create(TOK_INTEGER_LITERAL, start, p, line, col));
+      m_pos = p + 2;
+      return token_create(TOK_DOTDOT, p, m_pos, line, column(p));
+    }
+    is_float = true;
+    p++;
+    while (p < m_end && has_class(*p, CC_DIGIT)) {
+      p++;
+    }
+  }
+
+  if (p < m_end && (*p == 'e' || *p == 'E')) {
+    is_float = true;
+    p++;
+    if (p < m_end && (*p == '+' || *p == '-')) {
+      p++;
+    }
+    if (p == m_end || !has_class(*p, CC_DIGIT)) {
+      m_pos = p < m_end ? p + 1 : p;
+      SyntaxError::raise(get_current_loc(), "Invalid float literal '%s'", std::string(start, p - start).c_str());
+    }
+    while (p < m_end && has_class(*p, CC_DIGIT)) {
+      p++;
+    }
   }
+
+  m_pos = p;
+  return token_create(is_float ? TOK_FLOAT_LITERAL : TOK_INTEGER_LITERAL, start, p, line, col);
 }
 
-Node *Lexer::string_create(const std::string &lexeme_start, int line, int col) {
-  std::string lexeme = lexeme_start;
-  lexeme.pop_back();
+// Read a string literal, whose opening quote has just been read.
+Token Lexer::string_create(int line, int col) {
+  // fast path: the lexeme is a span of the source if there are no escapes
+  const char *p = m_pos;
+  while (p < m_end && *p != '"' && *p != '\\') {
+    if (*p == '\n') {
+      m_line++;
+      m_line_start = p + 1;
+    }
+    p++;
+  }
+  if (p < m_end && *p == '"') {
+    const char *start = m_pos;
+    m_pos = p + 1;
+    return token_create(TOK_STRING, start, p, line, col);
+  }
+
+  // slow path: decode the escapes into a copy
+  m_strings.emplace_back(m_pos, p - m_pos);
+  std::string &lexeme = m_strings.back();
+  m_pos = p;
+
   while (true) {
     int c = read();
     if (c < 0) {
@@ -252,6 +427,5 @@ Node *Lexer::string_create(const std::string &lexeme_start, int line, int col) {
       lexeme.push_back(static_cast<char>(c));
     }
   }
-  return token_create(TOK_STRING, lexeme, line, col);
+  return token_create(TOK_STRING, lexeme.data(), lexeme.data() + lexeme.size(), line, col);
 }
-
@@ -3,16 +3,33 @@
 
 #include <deque>
 #include <cstdio>
+#include <memory>
+#include <string>
 #include "token.h"
-#include "node.h"
+#include "location.h"
 
+// The Lexer scans the whole source text in memory: a memory mapping of
+// the input file, or a copy of the input if it can't be mapped (e.g.,
+// if it is a pipe).  Tokens are scanned with pointer arithmetic, and
+// each token's lexeme is its span of the source, except for string
+// literals with escapes, whose decoded text is kept in m_strings.
+// Lookahead tokens are kept in a small ring buffer.
 class Lexer {
 private:
+  // capacity of the lookahead ring buffer (a power of 2); scanning
+  // "1..5" adds two tokens at once, so peek can look one less ahead
+  static const int LOOKAHEAD_MAX = 4;
+
   FILE *m_in;
-  std::deque<Node *> m_lookahead;
+  std::shared_ptr<const char> m_source;
+  const char *m_pos, *m_end;
+  Token m_lookahead[LOOKAHEAD_MAX];
+  int m_lookahead_head, m_lookahead_count;
+  std::deque<std::string> m_strings;
   std::string m_filename;
-  int m_line, m_col;
-  bool m_eof;
+  int m_line;
+  // the start of the current line, for computing columns
+  const char *m_line_start;
 
 public:
   Lexer(FILE *in, const std::string &filename);
@@ -21,27 +38,34 @@ public:
   // Consume the next token.
   // Throws SyntaxError if the input ends before
   // one token can be read.
-  Node *next();
+  Token next();
 
   // Look ahead and return a pointer to a future token
-  // without consuming it. The how_far parameter indicates
-  // how many tokens to look ahead (1 means return the
-  // next token, 2 means the token after the next token,
-  // etc.)
-  Node *peek(int how_far = 1);
+  // without consuming it, or nullptr if the input ends first.
+  // The how_far parameter indicates how many tokens to look
+  // ahead (1 means return the next token, 2 means the token
+  // after the next token, etc.)  The pointer is valid until
+  // the token is consumed.
+  const Token *peek(int how_far = 1);
 
+  Location get_loc(const Token &tok) const;
   Location get_current_loc() const;
 
 private:
+  void load_source();
   int read();
-  void unread(int c);
+  int column(const char *p) const { return int(p - m_line_start) + 1; }
   void fill(int how_many);
-  Node *read_token();
-  Node *token_create(enum TokenKind kind, const std::string &lexeme, int line, int col);
-  Node *read_continued_token(enum TokenKind kind, const std::string &lexeme_start, int line, int col, int (*pred)(int));
+  void push_token(const Token &tok);
+  bool read_token(Token &tok);
+  Token token_create(enum TokenKind kind, const char *start, const char *end, int line, int col);
+  Token identifier_create(const char *start, int line, int col);
   // DONE: add additional member functions if necessary
-  Node *try_two_character_token(char first, char second, TokenKind oneCharKind, TokenKind twoCharKind, int line, int col);
-  Node *string_create(const std::string &lexeme_start, int line, int col);
+  Token try_two_character_token(char first, char second, TokenKind oneCharKind, TokenKind twoCharKind, int line, int col);
+  Token try_two_character_token(char first, char second, char other_second, TokenKind oneCharKind,
+                                TokenKind twoCharKind, TokenKind otherTwoCharKind, int line, int col);
+  Token string_create(int line, int col);
+  Token number_create(const char *start, int line, int col);
 };
 
 #endif // LEXER_H
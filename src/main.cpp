@@ -55,11 +55,10 @@ int execute(int argc, char **argv) {
   if (mode == PRINT_TOKENS) {
     // just print the tokens
     while (lexer->peek() != nullptr) {
-      Node *tok = lexer->next();
-      int kind = tok->get_tag();
-      std::string lexeme = tok->get_str();
+      Token tok = lexer->next();
+      int kind = tok.get_tag();
+      std::string lexeme = tok.get_str();
       printf("%d:%s\n", kind, lexeme.c_str());
-      delete tok;
     }
   } else if (mode == PRINT_AST || mode == EXECUTE) {
     // Create parser and parse the input
@@ -76,7 +75,10 @@ int execute(int argc, char **argv) {
       Interpreter interp(ast.release());
 //      interp.analyze();
       Value result = interp.execute();
-      printf("Result: %s\n", result.as_str().c_str());
+      OutputBuffer &out = interp.get_output();
+      out.write("Result: ");
+      out.write_value(result);
+      out.end_line();
     }
   }
 
@@ -0,0 +1,156 @@
+#include <utility>
+#include "map.h"
+#include "array.h"
+#include "string.h"
+#include "exceptions.h"
+
+namespace {
+const size_t MIN_CAPACITY = 8;
+}
+
+Map::Map()
+  : ValRep(VALREP_MAP)
+  , m_size(0) {
+}
+
+Map::~Map() {
+}
+
+Value *Map::find(const Value &key, const Location &location) {
+  int index = find_index(key, hash_key(key, location));
+  return index >= 0 ? &m_slots[index].value : nullptr;
+}
+
+void Map::put(const Value &key, const Value &val, const Location &location) {
+  size_t hash = hash_key(key, location);
+  int index = find_index(key, hash);
+  if (index >= 0) {
+    m_slots[index].value = val;
+    return;
+  }
+  // keep the load factor at or below 7/8
+  if ((m_size + 1) * 8 > int(m_slots.size()) * 7) {
+    grow();
+  }
+  insert(key, val, hash);
+  ++m_size;
+}
+
+bool Map::remove(const Value &key, const Location &location) {
+  int index = find_index(key, hash_key(key, location));
+  if (index < 0) {
+    return false;
+  }
+  // shift the following entries of the probe sequence back by one
+  size_t mask = m_slots.size() - 1;
+  size_t i = size_t(index), next = (i + 1) & mask;
+  while (m_slots[next].dist > 0) {
+    m_slots[i].key = m_slots[next].key;
+    m_slots[i].value = m_slots[next].value;
+    m_slots[i].hash = m_slots[next].hash;
+    m_slots[i].dist = m_slots[next].dist - 1;
+    i = next;
+    next = (next + 1) & mask;
+  }
+  m_slots[i].key = Value();
+  m_slots[i].value = Value();
+  m_slots[i].dist = -1;
+  --m_size;
+  return true;
+}
+
+Value Map::keys() const {
+  std::vector<Value> keys;
+  keys.reserve(m_size);
+  each_entry([&keys](const Value &key, const Value &) { keys.push_back(key); });
+  return Value(new Array(keys));
+}
+
+size_t Map::hash_key(const Value &key, const Location &location) {
+  size_t h;
+  switch (key.get_kind()) {
+    case VALUE_INT:
+      h = size_t(key.get_ival());
+      break;
+    case VALUE_STRING:
+      h = key.get_string()->hash();
+      break;
+    default:
+      EvaluationError::raise(location, "Map keys must be 64-bit integers or strings");
+  }
+  // finalizer from splitmix64, so that the low bits (which select
+  // the home slot) depend on all of the bits of the key
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9UL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebUL;
+  h ^= h >> 31;
+  return h;
+}
+
+bool Map::keys_equal(const Value &a, const Value &b) {
+  if (a.get_kind() != b.get_kind()) {
+    return false;
+  }
+  if (a.get_kind() == VALUE_INT) {
+    return a.get_ival() == b.get_ival();
+  }
+  return a.get_string()->equals(b.get_string());
+}
+
+int Map::find_index(const Value &key, size_t hash) const {
+  if (m_slots.empty()) {
+    return -1;
+  }
+  size_t mask = m_slots.size() - 1;
+  size_t i = hash & mask;
+  for (int dist = 0; ; dist++) {
+    const Slot &slot = m_slots[i];
+    // an entry closer to its home slot than we are to ours means
+    // the key would have been placed before it
+    if (slot.dist < dist) {
+      return -1;
+    }
+    if (slot.hash == hash && keys_equal(slot.key, key)) {
+      return int(i);
+    }
+    i = (i + 1) & mask;
+  }
+}
+
+void Map::insert(Value key, Value val, size_t hash) {
+  size_t mask = m_slots.size() - 1;
+  size_t i = hash & mask;
+  int dist = 0;
+  for (;;) {
+    Slot &slot = m_slots[i];
+    if (slot.dist < 0) {
+      slot.key = key;
+      slot.value = val;
+      slot.hash = hash;
+      slot.dist = dist;
+      return;
+    }
+    if (slot.dist < dist) {
+      // take from the rich: the displaced entry continues probing
+      std::swap(slot.key, key);
+      std::swap(slot.value, val);
+      std::swap(slot.hash, hash);
+      std::swap(slot.dist, dist);
+    }
+    i = (i + 1) & mask;
+    dist++;
+  }
+}
+
+void Map::grow() {
+  std::vector<Slot> old_slots;
+  old_slots.swap(m_slots);
+  size_t capacity = old_slots.empty() ? MIN_CAPACITY : old_slots.size() * 2;
+  m_slots.resize(capacity, Slot{Value(), Value(), 0, -1});
+  for (auto i = old_slots.begin(); i != old_slots.end(); ++i) {
+    if (i->dist >= 0) {
+      insert(i->key, i->value, i->hash);
+    }
+  }
+}
@@ -0,0 +1,64 @@
+#ifndef MAP_H
+#define MAP_H
+
+#include <cstddef>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// A hash map from int or string keys to values.
+// The table uses open addressing with Robin Hood hashing: each entry
+// records its distance from its home slot, and an insertion displaces
+// entries that are closer to their home slot than the one being inserted.
+// This keeps probe sequences short and lets lookups stop early, and
+// removal uses backward shifting, so there are no tombstones.
+class Map : public ValRep {
+private:
+  struct Slot {
+    Value key;
+    Value value;
+    size_t hash;
+    int dist; // distance from the home slot, or -1 if the slot is empty
+  };
+
+  std::vector<Slot> m_slots; // size is zero or a power of 2
+  int m_size;
+
+public:
+  Map();
+  virtual ~Map();
+
+  int len() const { return m_size; }
+
+  // Return a pointer to the value associated with key, or nullptr
+  // if there is no such key.  The pointer is only valid until the
+  // map is next modified.
+  Value *find(const Value &key, const Location &location);
+
+  void put(const Value &key, const Value &val, const Location &location);
+  bool remove(const Value &key, const Location &location);
+
+  Value keys() const;
+
+  // invoke a function on each key/value pair
+  template<typename Fn>
+  void each_entry(Fn fn) const {
+    for (auto i = m_slots.begin(); i != m_slots.end(); ++i) {
+      if (i->dist >= 0) {
+        fn(i->key, i->value);
+      }
+    }
+  }
+
+private:
+  static size_t hash_key(const Value &key, const Location &location);
+  static bool keys_equal(const Value &a, const Value &b);
+  int find_index(const Value &key, size_t hash) const;
+  void insert(Value key, Value val, size_t hash);
+  void grow();
+};
+
+#endif //MAP_H
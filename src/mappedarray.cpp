@@ -0,0 +1,136 @@
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "mappedarray.h"
+#include "exceptions.h"
+
+namespace {
+
+const char MAGIC[8] = { 'M', 'L', 'A', 'R', 'R', 'A', 'Y', '1' };
+
+struct Header {
+  char magic[8];
+  int64_t len;
+};
+
+}
+
+MappedArray::MappedArray(const std::string &path, const std::string &tmp_path, void *map, size_t map_len, int size)
+  : ValRep(VALREP_MAPPED_ARRAY)
+  , m_path(path)
+  , m_tmp_path(tmp_path)
+  , m_map(map)
+  , m_map_len(map_len)
+  , m_data(reinterpret_cast<int64_t *>(static_cast<char *>(map) + sizeof(Header)))
+  , m_size(size)
+  , m_writable(!tmp_path.empty()) {
+}
+
+MappedArray::~MappedArray() {
+  munmap(m_map, m_map_len);
+  if (!m_tmp_path.empty()) {
+    // never finished
+    unlink(m_tmp_path.c_str());
+  }
+}
+
+Value MappedArray::create(const std::string &path, int n, const Location &loc) {
+  if (n < 0) {
+    EvaluationError::raise(loc, "Negative mapped array length: %d", n);
+  }
+  // a temporary file in the same directory, so it can be renamed over path
+  std::string tmp_template = path + ".XXXXXX";
+  std::vector<char> tmp_path(tmp_template.begin(), tmp_template.end());
+  tmp_path.push_back('\0');
+  int fd = mkstemp(tmp_path.data());
+  if (fd < 0) {
+    EvaluationError::raise(loc, "Cannot create mapped array '%s': %s", path.c_str(), strerror(errno));
+  }
+  // mkstemp makes the file private; give it the usual permissions
+  mode_t mask = umask(0);
+  umask(mask);
+  fchmod(fd, 0666 & ~mask);
+
+  // the file starts out as zeroes, including the header, which is
+  // written by finish
+  size_t map_len = sizeof(Header) + size_t(n) * sizeof(int64_t);
+  void *map = MAP_FAILED;
+  if (ftruncate(fd, off_t(map_len)) == 0) {
+    map = mmap(nullptr, map_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  int err = errno;
+  close(fd);
+  if (map == MAP_FAILED) {
+    unlink(tmp_path.data());
+    EvaluationError::raise(loc, "Cannot create mapped array '%s': %s", path.c_str(), strerror(err));
+  }
+  return Value(new MappedArray(path, tmp_path.data(), map, map_len, n));
+}
+
+Value MappedArray::open(const std::string &path, const Location &loc) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    EvaluationError::raise(loc, "Cannot open mapped array '%s': %s", path.c_str(), strerror(errno));
+  }
+  struct stat st;
+  Header header;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(Header) ||
+      pread(fd, &header, sizeof(header), 0) != ssize_t(sizeof(header)) ||
+      memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.len < 0 || header.len > INT32_MAX ||
+      size_t(st.st_size) != sizeof(Header) + size_t(header.len) * sizeof(int64_t)) {
+    close(fd);
+    EvaluationError::raise(loc, "Not a mapped array file: '%s'", path.c_str());
+  }
+  size_t map_len = size_t(st.st_size);
+  void *map = mmap(nullptr, map_len, PROT_READ, MAP_SHARED, fd, 0);
+  int err = errno;
+  close(fd);
+  if (map == MAP_FAILED) {
+    EvaluationError::raise(loc, "Cannot open mapped array '%s': %s", path.c_str(), strerror(err));
+  }
+  return Value(new MappedArray(path, "", map, map_len, int(header.len)));
+}
+
+Value MappedArray::get(int index, const Location &loc) const {
+  if (index < 0 || index >= m_size) {
+    EvaluationError::raise(loc, "Array index out of bound: %d", index);
+  }
+  return Value(m_data[index]);
+}
+
+Value MappedArray::set(int index, const Value &val, const Location &loc) {
+  if (index < 0 || index >= m_size) {
+    EvaluationError::raise(loc, "Array index out of bound: %d", index);
+  }
+  if (!m_writable) {
+    EvaluationError::raise(loc, "Assignment to a read-only mapped array");
+  }
+  if (val.get_kind() != VALUE_INT) {
+    EvaluationError::raise(loc, "Only 64-bit integers can be stored in a mapped array");
+  }
+  m_data[index] = val.get_ival();
+  return val;
+}
+
+void MappedArray::finish(const Location &loc) {
+  if (m_tmp_path.empty()) {
+    EvaluationError::raise(loc, "Mapped array '%s' is not being built", m_path.c_str());
+  }
+  // the header goes in last, so the file isn't valid until now
+  Header header;
+  memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.len = m_size;
+  memcpy(m_map, &header, sizeof(header));
+  if (rename(m_tmp_path.c_str(), m_path.c_str()) != 0) {
+    EvaluationError::raise(loc, "Cannot finish mapped array '%s': %s", m_path.c_str(), strerror(errno));
+  }
+  m_tmp_path.clear();
+  m_writable = false;
+  mprotect(m_map, m_map_len, PROT_READ);
+}
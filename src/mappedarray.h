@@ -0,0 +1,52 @@
+#ifndef MAPPEDARRAY_H
+#define MAPPEDARRAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "valrep.h"
+#include "value.h"
+
+class Location;
+
+// A fixed-length array of 64-bit ints whose packed storage is a shared
+// memory mapping of a file, so that a table built once can be reopened
+// by later runs (and shared by concurrent ones) without rebuilding it.
+//
+// The file is a 16-byte header (a magic number and the length) followed
+// by the elements in native byte order.  An array made by create is
+// writable, and is built in a temporary file next to its path; finish
+// writes the header and renames the file into place, so that processes
+// with the old file mapped are unaffected and an unfinished build is
+// never seen at the path.  Then it is read-only, like an array reopened
+// with open.
+class MappedArray : public ValRep {
+private:
+  std::string m_path;
+  // the temporary file, while the array is being built
+  std::string m_tmp_path;
+  void *m_map;
+  size_t m_map_len;
+  int64_t *m_data;
+  int m_size;
+  bool m_writable;
+
+  MappedArray(const std::string &path, const std::string &tmp_path, void *map, size_t map_len, int size);
+
+public:
+  virtual ~MappedArray();
+
+  // A new array of n zeroes, to replace any existing file at path when
+  // it is finished (it is discarded if it never is)
+  static Value create(const std::string &path, int n, const Location &loc);
+  // An existing array, read-only
+  static Value open(const std::string &path, const Location &loc);
+
+  int len() const { return m_size; }
+  Value get(int index, const Location &loc) const;
+  Value set(int index, const Value &val, const Location &loc);
+  // Put an array made by create in place at its path
+  void finish(const Location &loc);
+};
+
+#endif // MAPPEDARRAY_H
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include "matrix.h"
+#include "exceptions.h"
+
+// As in bitset.cpp, GCC builds an AVX2 version of the inner kernels
+// on x86-64 and selects it at load time if the CPU supports it.
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#  define MATRIX_AVX2_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#  define MATRIX_AVX2_CLONES
+#endif
+
+namespace {
+
+// Matrices are processed in square tiles of this many rows and columns,
+// so that the tiles being worked on stay in the L1/L2 cache
+const int BLOCK = 64;
+
+// Products needing at least this many multiply-adds are split
+// across threads by blocks of rows
+const long PARALLEL_THRESHOLD = 1L << 24;
+
+// c[i][j] += a[i][p] * b[p][j] for the rows [row_begin, row_end) of c,
+// where a is n x k, b is k x m, and c is n x m (all packed).  The sums
+// are 64-bit; the caller checks that they can't overflow.
+MATRIX_AVX2_CLONES
+void multiply_rows(const int *__restrict a, const int *__restrict b, int64_t *__restrict c,
+                   int row_begin, int row_end, int k, int m) {
+  for (int ii = row_begin; ii < row_end; ii += BLOCK) {
+    int i_end = std::min(ii + BLOCK, row_end);
+    for (int pp = 0; pp < k; pp += BLOCK) {
+      int p_end = std::min(pp + BLOCK, k);
+      for (int jj = 0; jj < m; jj += BLOCK) {
+        int j_end = std::min(jj + BLOCK, m);
+        for (int i = ii; i < i_end; i++) {
+          int64_t *c_row = c + long(i) * m;
+          for (int p = pp; p < p_end; p++) {
+            int64_t a_ip = a[long(i) * k + p];
+            const int *b_row = b + long(p) * m;
+            // contiguous in j: vectorizes
+            for (int j = jj; j < j_end; j++) {
+              c_row[j] += a_ip * b_row[j];
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// The same product, one element at a time with 128-bit sums, for when
+// the 64-bit sums of multiply_rows might overflow
+void multiply_wide(const int *a, const int *b, int64_t *c, int n, int k, int m, bool *overflow) {
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < m; j++) {
+      __int128 sum = 0;
+      for (int p = 0; p < k; p++) {
+        sum += int64_t(a[long(i) * k + p]) * b[long(p) * m + j];
+      }
+      if (sum < INT32_MIN || sum > INT32_MAX) {
+        *overflow = true;
+        return;
+      }
+      c[long(i) * m + j] = int64_t(sum);
+    }
+  }
+}
+
+int64_t max_magnitude(const int *data, size_t n) {
+  int64_t max = 0;
+  for (size_t i = 0; i < n; i++) {
+    max = std::max(max, std::abs(int64_t(data[i])));
+  }
+  return max;
+}
+
+// c[i] = a[i] op b[i], computed in 64 bits; returns false if any
+// result doesn't fit in 32 bits
+MATRIX_AVX2_CLONES
+bool elementwise_kernel(const int *__restrict a, const int *__restrict b, int *__restrict c,
+                        size_t n, Matrix::ElementwiseOp op) {
+  bool fits = true;
+  switch (op) {
+    case Matrix::ELEMENTWISE_ADD:
+      for (size_t i = 0; i < n; i++) {
+        int64_t r = int64_t(a[i]) + b[i];
+        fits &= r == int32_t(r);
+        c[i] = int32_t(r);
+      }
+      break;
+    case Matrix::ELEMENTWISE_SUB:
+      for (size_t i = 0; i < n; i++) {
+        int64_t r = int64_t(a[i]) - b[i];
+        fits &= r == int32_t(r);
+        c[i] = int32_t(r);
+      }
+      break;
+    case Matrix::ELEMENTWISE_MUL:
+      for (size_t i = 0; i < n; i++) {
+        int64_t r = int64_t(a[i]) * b[i];
+        fits &= r == int32_t(r);
+        c[i] = int32_t(r);
+      }
+      break;
+  }
+  return fits;
+}
+
+}
+
+Matrix::Matrix(int rows, int cols, int fill)
+  : ValRep(VALREP_MATRIX)
+  , m_data(std::make_shared<std::vector<int>>(size_t(rows) * cols, fill))
+  , m_offset(0)
+  , m_rows(rows)
+  , m_cols(cols)
+  , m_row_stride(cols)
+  , m_col_stride(1) {
+}
+
+Matrix::Matrix(const std::shared_ptr<std::vector<int>> &data, size_t offset,
+               int rows, int cols, long row_stride, long col_stride)
+  : ValRep(VALREP_MATRIX)
+  , m_data(data)
+  , m_offset(offset)
+  , m_rows(rows)
+  , m_cols(cols)
+  , m_row_stride(row_stride)
+  , m_col_stride(col_stride) {
+}
+
+Matrix::~Matrix() {
+}
+
+int Matrix::get(int row, int col, const Location &location) const {
+  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols) {
+    EvaluationError::raise(location, "Matrix index out of bound: (%d, %d)", row, col);
+  }
+  return at(row, col);
+}
+
+int Matrix::set(int row, int col, int val, const Location &location) {
+  if (row < 0 || row >= m_rows || col < 0 || col >= m_cols) {
+    EvaluationError::raise(location, "Matrix index out of bound: (%d, %d)", row, col);
+  }
+  (*m_data)[m_offset + row * m_row_stride + col * m_col_stride] = val;
+  return val;
+}
+
+Value Matrix::row(int row, const Location &location) {
+  if (row < 0 || row >= m_rows) {
+    EvaluationError::raise(location, "Matrix row out of bound: %d", row);
+  }
+  return Value(new Matrix(m_data, m_offset + row * m_row_stride, 1, m_cols, m_row_stride, m_col_stride));
+}
+
+Value Matrix::col(int col, const Location &location) {
+  if (col < 0 || col >= m_cols) {
+    EvaluationError::raise(location, "Matrix column out of bound: %d", col);
+  }
+  return Value(new Matrix(m_data, m_offset + col * m_col_stride, m_rows, 1, m_row_stride, m_col_stride));
+}
+
+Value Matrix::transpose() const {
+  Matrix *result = new Matrix(m_cols, m_rows);
+  int *dst = result->m_data->data();
+  // transpose tile by tile, so neither the reads nor the writes
+  // stride through more memory than fits in the cache
+  for (int ii = 0; ii < m_rows; ii += BLOCK) {
+    int i_end = std::min(ii + BLOCK, m_rows);
+    for (int jj = 0; jj < m_cols; jj += BLOCK) {
+      int j_end = std::min(jj + BLOCK, m_cols);
+      for (int i = ii; i < i_end; i++) {
+        for (int j = jj; j < j_end; j++) {
+          dst[long(j) * m_rows + i] = at(i, j);
+        }
+      }
+    }
+  }
+  return Value(result);
+}
+
+Value Matrix::multiply(const Matrix *a, const Matrix *b, const Location &location) {
+  if (a->m_cols != b->m_rows) {
+    EvaluationError::raise(location, "Cannot multiply a %dx%d matrix by a %dx%d matrix",
+                           a->m_rows, a->m_cols, b->m_rows, b->m_cols);
+  }
+  int n = a->m_rows, k = a->m_cols, m = b->m_cols;
+  std::vector<int> a_copy, b_copy;
+  const int *a_data = a->is_packed() ? a->packed_data() : (a_copy = a->packed_copy()).data();
+  const int *b_data = b->is_packed() ? b->packed_data() : (b_copy = b->packed_copy()).data();
+
+  Matrix *result = new Matrix(n, m);
+  Value result_val(result);
+  std::vector<int64_t> sums(size_t(n) * m);
+  int64_t *c_data = sums.data();
+
+  // the 64-bit sums can't overflow if k * max|a| * max|b| fits
+  unsigned __int128 bound = (unsigned __int128) k * max_magnitude(a_data, size_t(n) * k) * max_magnitude(b_data, size_t(k) * m);
+  unsigned nthreads = std::thread::hardware_concurrency();
+  long work = long(n) * k * m;
+  bool overflow = false;
+  if (bound > INT64_MAX) {
+    multiply_wide(a_data, b_data, c_data, n, k, m, &overflow);
+  } else if (work < PARALLEL_THRESHOLD || nthreads < 2 || n < 2 * BLOCK) {
+    multiply_rows(a_data, b_data, c_data, 0, n, k, m);
+  } else {
+    // each thread computes a band of whole rows of the result
+    nthreads = std::min(nthreads, unsigned((n + BLOCK - 1) / BLOCK));
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < nthreads; t++) {
+      int row_begin = int(long(n) * t / nthreads), row_end = int(long(n) * (t + 1) / nthreads);
+      threads.emplace_back(multiply_rows, a_data, b_data, c_data, row_begin, row_end, k, m);
+    }
+    for (auto &t : threads) {
+      t.join();
+    }
+  }
+
+  int *dst = result->m_data->data();
+  for (size_t i = 0; !overflow && i < sums.size(); i++) {
+    overflow = sums[i] < INT32_MIN || sums[i] > INT32_MAX;
+    dst[i] = int(sums[i]);
+  }
+  if (overflow) {
+    EvaluationError::raise(location, "Matrix product element out of 32-bit range");
+  }
+  return result_val;
+}
+
+Value Matrix::elementwise(const Matrix *a, const Matrix *b, ElementwiseOp op, const Location &location) {
+  if (a->m_rows != b->m_rows || a->m_cols != b->m_cols) {
+    EvaluationError::raise(location, "Matrix dimensions do not match: %dx%d and %dx%d",
+                           a->m_rows, a->m_cols, b->m_rows, b->m_cols);
+  }
+  std::vector<int> a_copy, b_copy;
+  const int *a_data = a->is_packed() ? a->packed_data() : (a_copy = a->packed_copy()).data();
+  const int *b_data = b->is_packed() ? b->packed_data() : (b_copy = b->packed_copy()).data();
+
+  Matrix *result = new Matrix(a->m_rows, a->m_cols);
+  Value result_val(result);
+  if (!elementwise_kernel(a_data, b_data, result->m_data->data(), size_t(a->m_rows) * a->m_cols, op)) {
+    EvaluationError::raise(location, "Matrix element out of 32-bit range");
+  }
+  return result_val;
+}
+
+std::vector<int> Matrix::packed_copy() const {
+  std::vector<int> copy;
+  copy.reserve(size_t(m_rows) * m_cols);
+  for (int i = 0; i < m_rows; i++) {
+    for (int j = 0; j < m_cols; j++) {
+      copy.push_back(at(i, j));
+    }
+  }
+  return copy;
+}
@@ -0,0 +1,61 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include <memory>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// A dense matrix of ints, stored row-major in a packed array.
+// A Matrix may also be a view (e.g., a single row or column) of
+// another matrix's storage, described by an offset and strides;
+// writes through a view are visible in the matrix it views.
+class Matrix : public ValRep {
+public:
+  enum ElementwiseOp {
+    ELEMENTWISE_ADD,
+    ELEMENTWISE_SUB,
+    ELEMENTWISE_MUL,
+  };
+
+private:
+  std::shared_ptr<std::vector<int>> m_data;
+  size_t m_offset;
+  int m_rows, m_cols;
+  long m_row_stride, m_col_stride;
+
+  Matrix(const std::shared_ptr<std::vector<int>> &data, size_t offset,
+         int rows, int cols, long row_stride, long col_stride);
+
+public:
+  Matrix(int rows, int cols, int fill = 0);
+  virtual ~Matrix();
+
+  int rows() const { return m_rows; }
+  int cols() const { return m_cols; }
+
+  int get(int row, int col, const Location &location) const;
+  int set(int row, int col, int val, const Location &location);
+
+  // views of a single row or column
+  Value row(int row, const Location &location);
+  Value col(int col, const Location &location);
+
+  // These return a new (non-view) matrix
+  Value transpose() const;
+  static Value multiply(const Matrix *a, const Matrix *b, const Location &location);
+  static Value elementwise(const Matrix *a, const Matrix *b, ElementwiseOp op, const Location &location);
+
+private:
+  int at(int row, int col) const {
+    return (*m_data)[m_offset + row * m_row_stride + col * m_col_stride];
+  }
+  bool is_packed() const { return m_col_stride == 1 && m_row_stride == m_cols; }
+  const int *packed_data() const { return m_data->data() + m_offset; }
+  std::vector<int> packed_copy() const;
+};
+
+#endif //MATRIX_H
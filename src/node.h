@@ -60,7 +60,7 @@ public:
   int get_tag() const { return m_tag; }
   void set_tag(int tag) { m_tag = tag; }
 
-  std::string get_str() const { return m_str; }
+  const std::string &get_str() const { return m_str; }
   void set_str(const std::string &str) { m_str = str; }
 
   void append_kid(Node *kid);
@@ -18,10 +18,61 @@
 // ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 // OTHER DEALINGS IN THE SOFTWARE.
 
+#include <algorithm>
 #include "node_base.h"
 
-NodeBase::NodeBase() {
+NodeBase::NodeBase()
+  : m_cached_shape_id(0)
+  , m_cached_slot(-1)
+  , m_dense_cases(false)
+  , m_case_base(0)
+  , m_default_kid(-1) {
 }
 
 NodeBase::~NodeBase() {
 }
+
+void NodeBase::set_cases(const std::vector<std::pair<int64_t, int>> &cases, int default_kid) {
+  std::vector<std::pair<int64_t, int>> sorted(cases);
+  std::sort(sorted.begin(), sorted.end());
+  m_default_kid = default_kid;
+  m_case_values.clear();
+  m_case_kids.clear();
+  if (sorted.empty()) {
+    m_dense_cases = false;
+    return;
+  }
+
+  // use a jump table if at most about half of it would be unused
+  // (the range wraps to 0 only if it covers every int)
+  uint64_t range = uint64_t(sorted.back().first) - uint64_t(sorted.front().first) + 1;
+  m_dense_cases = range != 0 && range <= 2 * sorted.size() + 8;
+  if (m_dense_cases) {
+    m_case_base = sorted.front().first;
+    m_case_kids.assign(range, -1);
+    for (auto i = sorted.begin(); i != sorted.end(); ++i) {
+      m_case_kids[i->first - m_case_base] = i->second;
+    }
+  } else {
+    for (auto i = sorted.begin(); i != sorted.end(); ++i) {
+      m_case_values.push_back(i->first);
+      m_case_kids.push_back(i->second);
+    }
+  }
+}
+
+int NodeBase::find_case(int64_t value) const {
+  if (m_dense_cases) {
+    // unsigned comparison also rejects values below the base
+    uint64_t offset = uint64_t(value) - uint64_t(m_case_base);
+    if (offset < m_case_kids.size() && m_case_kids[offset] >= 0) {
+      return m_case_kids[offset];
+    }
+    return m_default_kid;
+  }
+  auto i = std::lower_bound(m_case_values.begin(), m_case_values.end(), value);
+  if (i != m_case_values.end() && *i == value) {
+    return m_case_kids[i - m_case_values.begin()];
+  }
+  return m_default_kid;
+}
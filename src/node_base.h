@@ -21,13 +21,31 @@
 #ifndef NODE_BASE_H
 #define NODE_BASE_H
 
+#include <cstdint>
+#include <vector>
+
 // The Node class will inherit from this type, so you can use it
 // to define any attributes and methods that Node objects should have
 // (constant value, results of semantic analysis, code generation info,
 // etc.)
 class NodeBase {
 private:
-  // fields could go here
+  // inline cache for record field access: the id of the
+  // last record Shape seen at this node (0 if none), and
+  // the slot of the accessed field in that Shape
+  int m_cached_shape_id;
+  int m_cached_slot;
+
+  // dispatch table for a switch statement, mapping case values to
+  // the index of the kid to execute.  If the cases are dense,
+  // m_case_kids[v - m_case_base] is the kid for value v (or -1);
+  // otherwise m_case_values is sorted, and m_case_kids holds the
+  // kid for each of them.  m_default_kid is -1 if there's no default.
+  bool m_dense_cases;
+  int64_t m_case_base;
+  std::vector<int64_t> m_case_values;
+  std::vector<int> m_case_kids;
+  int m_default_kid;
 
   // copy ctor and assignment operator not supported
   NodeBase(const NodeBase &);
@@ -36,6 +54,16 @@ private:
 public:
   NodeBase();
   virtual ~NodeBase();
+
+  int get_cached_shape_id() const { return m_cached_shape_id; }
+  int get_cached_slot() const { return m_cached_slot; }
+  void set_field_cache(int shape_id, int slot) { m_cached_shape_id = shape_id; m_cached_slot = slot; }
+
+  // build the switch dispatch table from the value and kid index of each case
+  void set_cases(const std::vector<std::pair<int64_t, int>> &cases, int default_kid);
+  // index of the kid to execute for value, or -1 if there's none
+  int find_case(int64_t value) const;
+  int get_default_case() const { return m_default_kid; }
 };
 
 #endif // NODE_BASE_H
@@ -0,0 +1,140 @@
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
+#include "outbuf.h"
+#include "value.h"
+#include "location.h"
+#include "array.h"
+#include "string.h"
+#include "bytes.h"
+#include "deque.h"
+#include "bigint.h"
+
+namespace {
+
+const size_t OUTPUT_BUFFER_SIZE = 64 * 1024;
+
+}
+
+OutputBuffer::OutputBuffer(int fd)
+  : m_fd(fd)
+  , m_line_buffered(isatty(fd))
+  , m_buf(OUTPUT_BUFFER_SIZE)
+  , m_used(0)
+  , m_error(0) {
+}
+
+OutputBuffer::~OutputBuffer() {
+  flush();
+}
+
+void OutputBuffer::write(const char *data, size_t len) {
+  if (len > m_buf.size() - m_used) {
+    flush();
+    if (len >= m_buf.size()) {
+      // too big to be worth copying: write it directly
+      write_all(data, len);
+      return;
+    }
+  }
+  memcpy(m_buf.data() + m_used, data, len);
+  m_used += len;
+}
+
+void OutputBuffer::write(const char *str) {
+  write(str, strlen(str));
+}
+
+void OutputBuffer::write_char(char c) {
+  if (m_used == m_buf.size()) {
+    flush();
+  }
+  m_buf[m_used++] = c;
+}
+
+void OutputBuffer::write_int(int64_t ival) {
+  char buf[24];
+  char *end = std::to_chars(buf, buf + sizeof(buf), ival).ptr;
+  write(buf, size_t(end - buf));
+}
+
+void OutputBuffer::write_value(const Value &val) {
+  switch (val.get_kind()) {
+    case VALUE_INT:
+      write_int(val.get_ival());
+      break;
+    case VALUE_DOUBLE: {
+      char buf[Value::DOUBLE_CHARS_MAX];
+      write(buf, Value::double_to_chars(buf, val.get_dval()));
+      break;
+    }
+    case VALUE_STRING: {
+      String *str = val.get_string();
+      write(str->data(), size_t(str->strlen()));
+      break;
+    }
+    case VALUE_BYTES: {
+      Bytes *bytes = val.get_bytes();
+      write(reinterpret_cast<const char *>(bytes->data()), size_t(bytes->len()));
+      break;
+    }
+    case VALUE_ARRAY: {
+      Array *arr = val.get_array();
+      Location loc;
+      write_char('[');
+      for (int i = 0; i < arr->len(); i++) {
+        if (i > 0)
+          write(", ", 2);
+        write_value(*arr->at(i, loc));
+      }
+      write_char(']');
+      break;
+    }
+    case VALUE_DEQUE: {
+      Deque *deque = val.get_deque();
+      Location loc;
+      write_char('[');
+      for (int i = 0; i < deque->len(); i++) {
+        if (i > 0)
+          write(", ", 2);
+        write_value(*deque->at(i, loc));
+      }
+      write_char(']');
+      break;
+    }
+    default: {
+      // everything else is rare enough to format as a std::string
+      std::string str = val.as_str();
+      write(str.data(), str.size());
+      break;
+    }
+  }
+}
+
+void OutputBuffer::end_line() {
+  write_char('\n');
+  if (m_line_buffered) {
+    flush();
+  }
+}
+
+void OutputBuffer::flush() {
+  write_all(m_buf.data(), m_used);
+  m_used = 0;
+}
+
+void OutputBuffer::write_all(const char *data, size_t len) {
+  while (len > 0 && m_error == 0) {
+    ssize_t n = ::write(m_fd, data, len);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      m_error = n < 0 ? errno : EIO;
+      break;
+    }
+    data += n;
+    len -= size_t(n);
+  }
+}
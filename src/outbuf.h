@@ -0,0 +1,54 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Value;
+
+// A buffer for a program's output, written to a file descriptor in
+// large blocks with write(2).  Values are formatted straight into the
+// buffer: ints and doubles with std::to_chars, and strings, bytes and
+// the elements of arrays and deques without temporary std::strings.
+//
+// When the file descriptor is a terminal, the buffer is flushed at the
+// end of each line, so interactive output appears promptly.
+//
+// Write errors are recorded rather than raised, since output may be
+// flushed anywhere; after the first error the rest of the output is
+// dropped.  Standard output ignores them (e.g., a closed pipe), as stdio
+// would, while a File checks them.
+class OutputBuffer {
+private:
+  int m_fd;
+  bool m_line_buffered;
+  std::vector<char> m_buf;
+  size_t m_used;
+  int m_error;
+
+  // copying would write the same output twice
+  OutputBuffer(const OutputBuffer &);
+  OutputBuffer &operator=(const OutputBuffer &);
+
+  void write_all(const char *data, size_t len);
+
+public:
+  OutputBuffer(int fd);
+  ~OutputBuffer();
+
+  void write(const char *data, size_t len);
+  void write(const char *str);
+  void write_char(char c);
+  void write_int(int64_t ival);
+  // formatted as by Value::as_str
+  void write_value(const Value &val);
+  // a newline, flushing if line buffered
+  void end_line();
+
+  void flush();
+  // errno of the first write that failed, or 0
+  int get_error() const { return m_error; }
+};
+
+#endif // OUTBUF_H
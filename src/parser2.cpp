@@ -82,11 +82,65 @@
 // PList -> ident                                  (New)
 // PList -> ident , PList                          (New)
 // F    -> string_literal                          (New)
+// F    -> float_literal                           (New)
+
+// Records :
+// TStmt -> Rec                                    (New)
+// Rec -> record ident { PList }                   (New)
+// A    -> F . ident = A                           (New) field assignment
+// F    -> P F'                                    (Changed)
+// F'   -> . ident F'                              (New) field access
+// F'   -> epsilon                                 (New)
+// P    -> number | ident | ( A ) | ident ( OptArgList ) | string_literal
+//                                                 (Changed) formerly F
+
+// Indexing and compound assignment :
+// A    -> F [ A ] = A                             (New) element assignment
+// A    -> F op= A                                 (New) op is one of + - * /, F is
+//                                                       ident, F . ident or F [ A ]
+// F'   -> [ A ] F'                                (New) element access
+// F'   -> ++                                      (New) postfix increment, as for op=
+// F'   -> --                                      (New) postfix decrement, as for op=
+
+// For loops :
+// Stmt -> for ( ident in A .. A ) { SList }       (New) from the first value up to,
+//                                                       but not including, the second
+// Stmt -> for ( ident in A ) { SList }            (New) elements of a container
+
+// Early exits :
+// Stmt -> break ;                                 (New) only in a loop
+// Stmt -> continue ;                              (New) only in a loop
+// Stmt -> return A ;                              (New) only in a function
+
+// Switch statements :
+// Stmt -> switch ( A ) { CList }                  (New) break only leaves the switch,
+//                                                       there is no fallthrough
+// CList -> Case CList                             (New)
+// CList -> epsilon                                (New)
+// Case -> case number : OptSList                  (New) number may be negated with -
+// Case -> default : OptSList                      (New) at most one
+// OptSList -> SList | epsilon                     (New)
+
+// Bitwise and modulo operators :
+// R    -> O relop O                               (Changed) formerly E relop E
+// O    -> O | X                                   (New) bitwise or
+// O    -> X                                       (New)
+// X    -> X ^ N                                   (New) bitwise exclusive or
+// X    -> N                                       (New)
+// N    -> N & S                                   (New) bitwise and
+// N    -> S                                       (New)
+// S    -> S << E                                  (New) shifts
+// S    -> S >> E                                  (New)
+// S    -> E                                       (New)
+// T'   -> % F T'                                  (New) remainder
 
 
 Parser2::Parser2(Lexer *lexer_to_adopt)
   : m_lexer(lexer_to_adopt)
-  , m_next(nullptr) {
+  , m_next(nullptr)
+  , m_loop_depth(0)
+  , m_in_function(false)
+  , m_switch_depth(0) {
 }
 
 Parser2::~Parser2() {
@@ -111,10 +165,13 @@ Node *Parser2::parse_Unit() {
 }
 
 Node *Parser2::parse_TStmt() {
-  Node *next_tok = m_lexer->peek();
+  const Token *next_tok = m_lexer->peek();
   if (next_tok->get_tag() == TOK_FUNCTION) {
     // TStmt -> Func
     return parse_Func();
+  } else if (next_tok->get_tag() == TOK_RECORD) {
+    // TStmt -> Rec
+    return parse_Rec();
   } else {
     // TStmt -> Stmt
     return parse_Stmt();
@@ -124,14 +181,14 @@ Node *Parser2::parse_TStmt() {
 Node *Parser2::parse_Func() {
   // Func -> function ident ( OptPList ) { SList }
   std::unique_ptr<Node> func(new Node(AST_FUNCTION));
-  func->set_loc(m_lexer->peek()->get_loc());
+  func->set_loc(m_lexer->get_loc(*m_lexer->peek()));
   expect_and_discard(TOK_FUNCTION);
 
   // AST node for the function name
-  std::unique_ptr<Node> ident(expect(TOK_IDENTIFIER));
+  Token ident = expect(TOK_IDENTIFIER);
   std::unique_ptr<Node> varRef(new Node(AST_VARREF));
-  varRef->set_str(ident->get_str());
-  varRef->set_loc(ident->get_loc());
+  varRef->set_str(ident.get_str());
+  varRef->set_loc(m_lexer->get_loc(ident));
   func->append_kid(varRef.release());
 
   // AST nodes for the parameters
@@ -142,23 +199,46 @@ Node *Parser2::parse_Func() {
   // AST nodes for the block
   std::unique_ptr<Node> block(new Node(AST_STATEMENT_LIST));
   expect_and_discard(TOK_LBRACE);
+  m_in_function = true;
   for (;;) {
     block->append_kid(parse_Stmt());
     if (m_lexer->peek() == nullptr || m_lexer->peek()->get_tag() == TOK_RBRACE)
       break;
   }
+  m_in_function = false;
   expect_and_discard(TOK_RBRACE);
   func->append_kid(block.release());
 
   return func.release();
 }
 
+Node *Parser2::parse_Rec() {
+  // Rec -> record ident { PList }
+  std::unique_ptr<Node> rec(new Node(AST_RECORD));
+  rec->set_loc(m_lexer->get_loc(*m_lexer->peek()));
+  expect_and_discard(TOK_RECORD);
+
+  // AST node for the record name
+  Token ident = expect(TOK_IDENTIFIER);
+  std::unique_ptr<Node> varRef(new Node(AST_VARREF));
+  varRef->set_str(ident.get_str());
+  varRef->set_loc(m_lexer->get_loc(ident));
+  rec->append_kid(varRef.release());
+
+  // AST nodes for the fields
+  expect_and_discard(TOK_LBRACE);
+  rec->append_kid(parse_PList(new Node(AST_PARAM_LIST)));
+  expect_and_discard(TOK_RBRACE);
+
+  return rec.release();
+}
+
 Node *Parser2::parse_OptPList() {
   // OptPList -> PList
   // OptPList -> epsilon
   std::unique_ptr<Node> ast(new Node(AST_PARAM_LIST));
 
-  Node *next_tok = m_lexer->peek(1);
+  const Token *next_tok = m_lexer->peek(1);
   if (next_tok != nullptr && next_tok->get_tag() != TOK_RPAREN) {
     // OptPList -> PList
     return parse_PList(ast.release());
@@ -170,12 +250,12 @@ Node *Parser2::parse_PList(Node *ast_){
   // PList -> ident
   // PList -> ident , PList
   for (;;) {
-    Node *ident = expect(TOK_IDENTIFIER);
+    Token ident = expect(TOK_IDENTIFIER);
     std::unique_ptr<Node> varRef(new Node(AST_VARREF));
-    varRef->set_str(ident->get_str());
-    varRef->set_loc(ident->get_loc());
+    varRef->set_str(ident.get_str());
+    varRef->set_loc(m_lexer->get_loc(ident));
     ast_->append_kid(varRef.release());
-    Node* next_tok = m_lexer->peek(1);
+    const Token *next_tok = m_lexer->peek(1);
     if (next_tok == nullptr || next_tok->get_tag() != TOK_COMMA)
       break;
     else {
@@ -190,7 +270,7 @@ Node *Parser2::parse_Stmt() {
   // Stmt -> A ;
   std::unique_ptr<Node> s(new Node(AST_STATEMENT));
 
-  Node *next_tok = m_lexer->peek();
+  const Token *next_tok = m_lexer->peek();
   if (next_tok == nullptr) {
     SyntaxError::raise(m_lexer->get_current_loc(), "Unexpected end of input looking for statement");
   }
@@ -200,16 +280,16 @@ Node *Parser2::parse_Stmt() {
 
     // Create AST nodes for the variable definition key
     std::unique_ptr<Node> varDef(new Node(AST_VARDEF));
-    varDef->set_loc(next_tok->get_loc());
+    varDef->set_loc(m_lexer->get_loc(*next_tok));
     expect_and_discard(TOK_VAR);
 
     // Check if the next token is an identifier
-    std::unique_ptr<Node> ident(expect(TOK_IDENTIFIER));
+    Token ident = expect(TOK_IDENTIFIER);
 
     // Create AST nodes for the identifier
     std::unique_ptr<Node> varRef(new Node(AST_VARREF));
-    varRef->set_str(ident->get_str());
-    varRef->set_loc(ident->get_loc());
+    varRef->set_str(ident.get_str());
+    varRef->set_loc(m_lexer->get_loc(ident));
 
     // Add as children to the variable definition node
     varDef->append_kid(varRef.release());
@@ -222,7 +302,7 @@ Node *Parser2::parse_Stmt() {
 
     // Create AST nodes for if key
     std::unique_ptr<Node> ifNode(new Node(AST_IF));
-    ifNode->set_loc(next_tok->get_loc());
+    ifNode->set_loc(m_lexer->get_loc(*next_tok));
     expect_and_discard(TOK_IF);
     expect_and_discard(TOK_LPAREN);
 
@@ -266,7 +346,7 @@ Node *Parser2::parse_Stmt() {
 
     // Create AST nodes for while key
     std::unique_ptr<Node> whileNode(new Node(AST_WHILE));
-    whileNode->set_loc(next_tok->get_loc());
+    whileNode->set_loc(m_lexer->get_loc(*next_tok));
     expect_and_discard(TOK_WHILE);
 
     // AST node for the condition
@@ -278,15 +358,87 @@ Node *Parser2::parse_Stmt() {
     // AST nodes for the block
     std::unique_ptr<Node> block(new Node(AST_STATEMENT_LIST));
     expect_and_discard(TOK_LBRACE);
+    m_loop_depth++;
     for (;;) {
       block->append_kid(parse_Stmt());
       if (m_lexer->peek() == nullptr || m_lexer->peek()->get_tag() == TOK_RBRACE)
         break;
     }
+    m_loop_depth--;
     expect_and_discard(TOK_RBRACE);
     whileNode->append_kid(block.release());
     s->append_kid(whileNode.release());
 
+  } else if (next_tok->get_tag() == TOK_FOR) {
+    // Stmt -> for ( ident in A .. A ) { SList }
+    // Stmt -> for ( ident in A ) { SList }
+
+    // Create AST nodes for for key
+    std::unique_ptr<Node> forNode(new Node(AST_FOR_EACH));
+    forNode->set_loc(m_lexer->get_loc(*next_tok));
+    expect_and_discard(TOK_FOR);
+    expect_and_discard(TOK_LPAREN);
+
+    // AST node for the loop variable
+    Token ident = expect(TOK_IDENTIFIER);
+    std::unique_ptr<Node> varRef(new Node(AST_VARREF));
+    varRef->set_str(ident.get_str());
+    varRef->set_loc(m_lexer->get_loc(ident));
+    forNode->append_kid(varRef.release());
+    expect_and_discard(TOK_IN);
+
+    // AST nodes for the range, or the container
+    forNode->append_kid(parse_A());
+    const Token *range_tok = m_lexer->peek();
+    if (range_tok != nullptr && range_tok->get_tag() == TOK_DOTDOT) {
+      expect_and_discard(TOK_DOTDOT);
+      forNode->set_tag(AST_FOR_RANGE);
+      forNode->append_kid(parse_A());
+    }
+    expect_and_discard(TOK_RPAREN);
+
+    // AST nodes for the block
+    std::unique_ptr<Node> block(new Node(AST_STATEMENT_LIST));
+    expect_and_discard(TOK_LBRACE);
+    m_loop_depth++;
+    for (;;) {
+      block->append_kid(parse_Stmt());
+      if (m_lexer->peek() == nullptr || m_lexer->peek()->get_tag() == TOK_RBRACE)
+        break;
+    }
+    m_loop_depth--;
+    expect_and_discard(TOK_RBRACE);
+    forNode->append_kid(block.release());
+    s->append_kid(forNode.release());
+
+  } else if (next_tok->get_tag() == TOK_BREAK || next_tok->get_tag() == TOK_CONTINUE) {
+    // Stmt -> break ;
+    // Stmt -> continue ;
+    Token tok = expect(static_cast<enum TokenKind>(next_tok->get_tag()));
+    if (m_loop_depth == 0 && (tok.get_tag() == TOK_CONTINUE || m_switch_depth == 0)) {
+      SyntaxError::raise(m_lexer->get_loc(tok), "'%s' outside of a loop", tok.get_str().c_str());
+    }
+    std::unique_ptr<Node> jump(new Node(tok.get_tag() == TOK_BREAK ? AST_BREAK : AST_CONTINUE));
+    jump->set_loc(m_lexer->get_loc(tok));
+    expect_and_discard(TOK_SEMICOLON);
+    s->append_kid(jump.release());
+
+  } else if (next_tok->get_tag() == TOK_SWITCH) {
+    // Stmt -> switch ( A ) { CList }
+    s->append_kid(parse_Switch());
+
+  } else if (next_tok->get_tag() == TOK_RETURN) {
+    // Stmt -> return A ;
+    std::unique_ptr<Node> ret(new Node(AST_RETURN));
+    ret->set_loc(m_lexer->get_loc(*next_tok));
+    if (!m_in_function) {
+      SyntaxError::raise(m_lexer->get_loc(*next_tok), "'return' outside of a function");
+    }
+    expect_and_discard(TOK_RETURN);
+    ret->append_kid(parse_A());
+    expect_and_discard(TOK_SEMICOLON);
+    s->append_kid(ret.release());
+
   } else {
     // Stmt -> ^ A ;
     s->append_kid(parse_A());
@@ -295,27 +447,103 @@ Node *Parser2::parse_Stmt() {
   return s.release();
 }
 
+Node *Parser2::parse_Switch() {
+  // Stmt -> switch ( A ) { CList }
+  std::unique_ptr<Node> switchNode(new Node(AST_SWITCH));
+  switchNode->set_loc(m_lexer->get_loc(*m_lexer->peek()));
+  expect_and_discard(TOK_SWITCH);
+
+  // AST node for the switch value
+  expect_and_discard(TOK_LPAREN);
+  switchNode->append_kid(parse_A());
+  expect_and_discard(TOK_RPAREN);
+
+  // AST nodes for the cases, and the value of each case
+  // with the index of its kid
+  std::vector<std::pair<int64_t, int>> cases;
+  int default_kid = -1;
+  expect_and_discard(TOK_LBRACE);
+  m_switch_depth++;
+  for (;;) {
+    const Token *next_tok = m_lexer->peek();
+    if (next_tok == nullptr || next_tok->get_tag() == TOK_RBRACE)
+      break;
+
+    std::unique_ptr<Node> caseNode;
+    if (next_tok->get_tag() == TOK_DEFAULT) {
+      // Case -> default : OptSList
+      if (default_kid >= 0) {
+        SyntaxError::raise(m_lexer->get_loc(*next_tok), "Multiple default cases in switch");
+      }
+      caseNode.reset(new Node(AST_DEFAULT));
+      caseNode->set_loc(m_lexer->get_loc(*next_tok));
+      expect_and_discard(TOK_DEFAULT);
+      default_kid = switchNode->get_num_kids();
+    } else {
+      // Case -> case number : OptSList
+      caseNode.reset(new Node(AST_CASE));
+      caseNode->set_loc(m_lexer->get_loc(*next_tok));
+      expect_and_discard(TOK_CASE);
+      bool negative = m_lexer->peek() != nullptr && m_lexer->peek()->get_tag() == TOK_MINUS;
+      if (negative) {
+        expect_and_discard(TOK_MINUS);
+      }
+      Token label = expect(TOK_INTEGER_LITERAL);
+      int64_t value;
+      try {
+        value = std::stoll((negative ? "-" : "") + label.get_str());
+      } catch (std::out_of_range &) {
+        SyntaxError::raise(m_lexer->get_loc(label), "Case value out of range");
+      }
+      for (auto i = cases.begin(); i != cases.end(); ++i) {
+        if (i->first == value) {
+          SyntaxError::raise(m_lexer->get_loc(label), "Duplicate case %lld in switch", (long long) value);
+        }
+      }
+      cases.push_back({value, int(switchNode->get_num_kids())});
+      caseNode->set_str(std::to_string(value));
+    }
+    expect_and_discard(TOK_COLON);
+
+    // AST nodes for the statements, up to the next case
+    std::unique_ptr<Node> block(new Node(AST_STATEMENT_LIST));
+    for (;;) {
+      const Token *tok = m_lexer->peek();
+      if (tok == nullptr || tok->get_tag() == TOK_RBRACE || tok->get_tag() == TOK_CASE || tok->get_tag() == TOK_DEFAULT)
+        break;
+      block->append_kid(parse_Stmt());
+    }
+    caseNode->append_kid(block.release());
+    switchNode->append_kid(caseNode.release());
+  }
+  m_switch_depth--;
+  expect_and_discard(TOK_RBRACE);
+
+  switchNode->set_cases(cases, default_kid);
+  return switchNode.release();
+}
+
 Node *Parser2::parse_A() {
   // A    -> ident = A
   // A    -> L
-  Node *next_tok = m_lexer->peek(1);
+  const Token *next_tok = m_lexer->peek(1);
   if (next_tok == nullptr) {
     SyntaxError::raise(m_lexer->get_current_loc(), "Unexpected end of input looking for A");
   }
   // Two tokens of look ahead
-  Node *next_next_tok = m_lexer->peek(2);
+  const Token *next_next_tok = m_lexer->peek(2);
   if (next_next_tok != nullptr && next_next_tok->get_tag() == TOK_ASSIGN && next_tok->get_tag() == TOK_IDENTIFIER) {
     // A    → ident = A
 
     // Create AST nodes for the identifier
     std::unique_ptr<Node> varRef(new Node(AST_VARREF));
     varRef->set_str(next_tok->get_str());
-    varRef->set_loc(next_tok->get_loc());
+    varRef->set_loc(m_lexer->get_loc(*next_tok));
     expect_and_discard(TOK_IDENTIFIER);
 
     // Create AST nodes for the assign sign
     std::unique_ptr<Node> assign(new Node(AST_ASSIGN));
-    assign->set_loc(next_next_tok->get_loc());
+    assign->set_loc(m_lexer->get_loc(*next_next_tok));
     expect_and_discard(TOK_ASSIGN);
 
     // Add as children to the assign node
@@ -327,7 +555,50 @@ Node *Parser2::parse_A() {
 
   } else {
     // A    → L
-    return parse_L();
+    std::unique_ptr<Node> ast(parse_L());
+
+    next_tok = m_lexer->peek(1);
+    if (next_tok == nullptr) {
+      return ast.release();
+    }
+    int next_tok_tag = next_tok->get_tag();
+    if (next_tok_tag == TOK_ASSIGN && (ast->get_tag() == AST_FIELDREF || ast->get_tag() == AST_INDEX)) {
+      // A    → F . ident = A
+      // A    → F [ A ] = A
+      std::unique_ptr<Node> assign(new Node(ast->get_tag() == AST_FIELDREF ? AST_FIELD_ASSIGN : AST_INDEX_ASSIGN));
+      assign->set_loc(m_lexer->get_loc(*next_tok));
+      expect_and_discard(TOK_ASSIGN);
+
+      Node* ast_A = parse_A();
+      assign->append_kid(ast.release());
+      assign->append_kid(ast_A);
+      return assign.release();
+    }
+    if (next_tok_tag == TOK_PLUS_ASSIGN || next_tok_tag == TOK_MINUS_ASSIGN ||
+        next_tok_tag == TOK_TIMES_ASSIGN || next_tok_tag == TOK_DIVIDE_ASSIGN) {
+      // A    → F op= A
+      Token op = expect(static_cast<enum TokenKind>(next_tok_tag));
+      check_assignable(ast.get(), op);
+      int op_tag;
+      switch (next_tok_tag) {
+        case TOK_PLUS_ASSIGN:
+          op_tag = AST_ADD_ASSIGN;
+          break;
+        case TOK_MINUS_ASSIGN:
+          op_tag = AST_SUB_ASSIGN;
+          break;
+        case TOK_TIMES_ASSIGN:
+          op_tag = AST_MULTIPLY_ASSIGN;
+          break;
+        default:
+          op_tag = AST_DIVIDE_ASSIGN;
+          break;
+      }
+      Node* ast_A = parse_A();
+      ast.reset(new Node(op_tag, {ast.release(), ast_A}));
+      ast->set_loc(m_lexer->get_loc(op));
+    }
+    return ast.release();
   }
 }
 
@@ -339,7 +610,7 @@ Node *Parser2::parse_L() {
   Node *ast_ = parse_R();
   std::unique_ptr<Node> ast(ast_);
 
-  Node *next_tok = m_lexer->peek(1);
+  const Token *next_tok = m_lexer->peek(1);
   if (next_tok == nullptr) {
     SyntaxError::raise(m_lexer->get_current_loc(), "Unexpected end of input looking for L");
   }
@@ -347,40 +618,40 @@ Node *Parser2::parse_L() {
   if (next_tok_tag == TOK_OR || next_tok_tag == TOK_AND)  {
     // L    → R || R
     // L    → R && R
-    std::unique_ptr<Node> op(expect(static_cast<enum TokenKind>(next_tok_tag)));
+    Token op = expect(static_cast<enum TokenKind>(next_tok_tag));
 
     // build AST for next term, incorporate into current AST
     Node *right = parse_R();
     ast.reset(new Node(next_tok_tag == TOK_OR ? AST_LOGICAL_OR : AST_LOGICAL_AND, {ast.release(), right}));
 
     // copy source information from operator node
-    ast->set_loc(op->get_loc());
+    ast->set_loc(m_lexer->get_loc(op));
   }
   return ast.release();
 }
 
 Node *Parser2::parse_R() {
-  //  R    → E < E
-  //  R    → E <= E
-  //  R    → E > E
-  //  R    → E >= E
-  //  R    → E == E
-  //  R    → E != E
-  //  R    → E
-
-  Node *ast_ = parse_E();
+  //  R    → O < O
+  //  R    → O <= O
+  //  R    → O > O
+  //  R    → O >= O
+  //  R    → O == O
+  //  R    → O != O
+  //  R    → O
+
+  Node *ast_ = parse_O();
   std::unique_ptr<Node> ast(ast_);
 
-  Node *next_tok = m_lexer->peek(1);
+  const Token *next_tok = m_lexer->peek(1);
   if (next_tok == nullptr) {
     SyntaxError::raise(m_lexer->get_current_loc(), "Unexpected end of input looking for R");
   }
   int next_tok_tag = next_tok->get_tag();
   if (next_tok_tag == TOK_LESS || next_tok_tag == TOK_GREATER || next_tok_tag == TOK_IS_EQUAL ||
   next_tok_tag == TOK_LESS_EQUAL || next_tok_tag == TOK_GREATER_EQUAL || next_tok_tag == TOK_NOT_EQUAL ){
-    std::unique_ptr<Node> op(expect(static_cast<enum TokenKind>(next_tok_tag)));
+    Token op = expect(static_cast<enum TokenKind>(next_tok_tag));
 
-    Node *right = parse_E();
+    Node *right = parse_O();
     int op_tag;
     switch (next_tok_tag) {
       case TOK_LESS:
@@ -398,12 +669,75 @@ Node *Parser2::parse_R() {
       case TOK_GREATER_EQUAL:
         op_tag = AST_GREATEREQUAL;
         break;
-      case TOK_NOT_EQUAL:
+      default:
+        // TOK_NOT_EQUAL
         op_tag = AST_ISNOTEQUAL;
         break;
     }
     ast.reset(new Node(op_tag, {ast.release(), right}));
-    ast->set_loc(op->get_loc());
+    ast->set_loc(m_lexer->get_loc(op));
+  }
+  return ast.release();
+}
+
+// The bitwise operators bind more tightly than the comparisons (unlike C),
+// so that "x & mask == 0" means "(x & mask) == 0".  Each level is
+// left-associative.
+Node *Parser2::parse_O() {
+  // O → X
+  // O → O | X
+  std::unique_ptr<Node> ast(parse_X());
+  const Token *next_tok;
+  while ((next_tok = m_lexer->peek()) != nullptr && next_tok->get_tag() == TOK_BITOR) {
+    Token op = expect(TOK_BITOR);
+    Node *right = parse_X();
+    ast.reset(new Node(AST_BITOR, {ast.release(), right}));
+    ast->set_loc(m_lexer->get_loc(op));
+  }
+  return ast.release();
+}
+
+Node *Parser2::parse_X() {
+  // X → N
+  // X → X ^ N
+  std::unique_ptr<Node> ast(parse_N());
+  const Token *next_tok;
+  while ((next_tok = m_lexer->peek()) != nullptr && next_tok->get_tag() == TOK_BITXOR) {
+    Token op = expect(TOK_BITXOR);
+    Node *right = parse_N();
+    ast.reset(new Node(AST_BITXOR, {ast.release(), right}));
+    ast->set_loc(m_lexer->get_loc(op));
+  }
+  return ast.release();
+}
+
+Node *Parser2::parse_N() {
+  // N → S
+  // N → N & S
+  std::unique_ptr<Node> ast(parse_S());
+  const Token *next_tok;
+  while ((next_tok = m_lexer->peek()) != nullptr && next_tok->get_tag() == TOK_BITAND) {
+    Token op = expect(TOK_BITAND);
+    Node *right = parse_S();
+    ast.reset(new Node(AST_BITAND, {ast.release(), right}));
+    ast->set_loc(m_lexer->get_loc(op));
+  }
+  return ast.release();
+}
+
+Node *Parser2::parse_S() {
+  // S → E
+  // S → S << E
+  // S → S >> E
+  std::unique_ptr<Node> ast(parse_E());
+  const Token *next_tok;
+  while ((next_tok = m_lexer->peek()) != nullptr &&
+         (next_tok->get_tag() == TOK_SHIFT_LEFT || next_tok->get_tag() == TOK_SHIFT_RIGHT)) {
+    int next_tok_tag = next_tok->get_tag();
+    Token op = expect(static_cast<enum TokenKind>(next_tok_tag));
+    Node *right = parse_E();
+    ast.reset(new Node(next_tok_tag == TOK_SHIFT_LEFT ? AST_SHIFT_LEFT : AST_SHIFT_RIGHT, {ast.release(), right}));
+    ast->set_loc(m_lexer->get_loc(op));
   }
   return ast.release();
 }
@@ -428,20 +762,20 @@ Node *Parser2::parse_EPrime(Node *ast_) {
   std::unique_ptr<Node> ast(ast_);
 
   // peek at next token
-  Node *next_tok = m_lexer->peek();
+  const Token *next_tok = m_lexer->peek();
   if (next_tok != nullptr) {
     int next_tok_tag = next_tok->get_tag();
     if (next_tok_tag == TOK_PLUS || next_tok_tag == TOK_MINUS)  {
       // E' -> ^ + T E'
       // E' -> ^ - T E'
-      std::unique_ptr<Node> op(expect(static_cast<enum TokenKind>(next_tok_tag)));
+      Token op = expect(static_cast<enum TokenKind>(next_tok_tag));
 
       // build AST for next term, incorporate into current AST
       Node *term_ast = parse_T();
       ast.reset(new Node(next_tok_tag == TOK_PLUS ? AST_ADD : AST_SUB, {ast.release(), term_ast}));
 
       // copy source information from operator node
-      ast->set_loc(op->get_loc());
+      ast->set_loc(m_lexer->get_loc(op));
 
       // continue recursively
       return parse_EPrime(ast.release());
@@ -466,25 +800,28 @@ Node *Parser2::parse_T() {
 Node *Parser2::parse_TPrime(Node *ast_) {
   // T' -> ^ * F T'
   // T' -> ^ / F T'
+  // T' -> ^ % F T'
   // T' -> ^ epsilon
 
   std::unique_ptr<Node> ast(ast_);
 
   // peek at next token
-  Node *next_tok = m_lexer->peek();
+  const Token *next_tok = m_lexer->peek();
   if (next_tok != nullptr) {
     int next_tok_tag = next_tok->get_tag();
-    if (next_tok_tag == TOK_TIMES || next_tok_tag == TOK_DIVIDE)  {
+    if (next_tok_tag == TOK_TIMES || next_tok_tag == TOK_DIVIDE || next_tok_tag == TOK_MOD)  {
       // T' -> ^ * F T'
       // T' -> ^ / F T'
-      std::unique_ptr<Node> op(expect(static_cast<enum TokenKind>(next_tok_tag)));
+      // T' -> ^ % F T'
+      Token op = expect(static_cast<enum TokenKind>(next_tok_tag));
 
       // build AST for next primary expression, incorporate into current AST
       Node *primary_ast = parse_F();
-      ast.reset(new Node(next_tok_tag == TOK_TIMES ? AST_MULTIPLY : AST_DIVIDE, {ast.release(), primary_ast}));
+      int op_tag = next_tok_tag == TOK_TIMES ? AST_MULTIPLY : next_tok_tag == TOK_DIVIDE ? AST_DIVIDE : AST_MODULO;
+      ast.reset(new Node(op_tag, {ast.release(), primary_ast}));
 
       // copy source information from operator node
-      ast->set_loc(op->get_loc());
+      ast->set_loc(m_lexer->get_loc(op));
 
       // continue recursively
       return parse_TPrime(ast.release());
@@ -497,29 +834,86 @@ Node *Parser2::parse_TPrime(Node *ast_) {
 }
 
 Node *Parser2::parse_F() {
-  // F -> ^ number
-  // F -> ^ ident
-  // F -> ^ ( E ) Done - Changed to F -> ^ ( A )
-  // F -> ^ ident ( OptArgList ) Done
-  // F -> ^ string_literal Done
+  // F -> ^ P F'
+
+  // Parse primary expression
+  Node *ast = parse_P();
+
+  // Continue with any field accesses
+  return parse_FPrime(ast);
+}
+
+Node *Parser2::parse_FPrime(Node *ast_) {
+  // F' -> ^ . ident F'
+  // F' -> ^ [ A ] F'
+  // F' -> ^ ++
+  // F' -> ^ --
+  // F' -> ^ epsilon
+
+  std::unique_ptr<Node> ast(ast_);
+
+  const Token *next_tok = m_lexer->peek();
+  if (next_tok != nullptr && next_tok->get_tag() == TOK_LBRACKET) {
+    Token op = expect(TOK_LBRACKET);
+    Node *index = parse_A();
+    expect_and_discard(TOK_RBRACKET);
+
+    // the container is the first child, the index the second
+    ast.reset(new Node(AST_INDEX, {ast.release(), index}));
+    ast->set_loc(m_lexer->get_loc(op));
+
+    // continue recursively
+    return parse_FPrime(ast.release());
+  }
+  if (next_tok != nullptr && (next_tok->get_tag() == TOK_INCREMENT || next_tok->get_tag() == TOK_DECREMENT)) {
+    // the result is the old value, so nothing may follow
+    Token op = expect(static_cast<enum TokenKind>(next_tok->get_tag()));
+    check_assignable(ast.get(), op);
+    ast.reset(new Node(op.get_tag() == TOK_INCREMENT ? AST_INCREMENT : AST_DECREMENT, {ast.release()}));
+    ast->set_loc(m_lexer->get_loc(op));
+    return ast.release();
+  }
+  if (next_tok != nullptr && next_tok->get_tag() == TOK_DOT) {
+    Token op = expect(TOK_DOT);
+    Token field = expect(TOK_IDENTIFIER);
+
+    // the field name is stored in the FIELDREF node, the record is its child
+    ast.reset(new Node(AST_FIELDREF, {ast.release()}));
+    ast->set_str(field.get_str());
+    ast->set_loc(m_lexer->get_loc(op));
 
-  Node *next_tok = m_lexer->peek();
+    // continue recursively
+    return parse_FPrime(ast.release());
+  }
+
+  // F' -> ^ epsilon
+  return ast.release();
+}
+
+Node *Parser2::parse_P() {
+  // P -> ^ number
+  // P -> ^ ident
+  // P -> ^ ( A )
+  // P -> ^ ident ( OptArgList )
+  // P -> ^ string_literal
+
+  const Token *next_tok = m_lexer->peek();
   if (next_tok == nullptr) {
     error_at_current_loc("Unexpected end of input looking for primary expression");
   }
 
   int tag = next_tok->get_tag();
 
-  // F -> ^ ident ( OptArgList )
-  Node *next_next_tok = m_lexer->peek(2);
+  // P -> ^ ident ( OptArgList )
+  const Token *next_next_tok = m_lexer->peek(2);
   if (next_next_tok != nullptr && next_next_tok->get_tag() == TOK_LPAREN && next_tok->get_tag() == TOK_IDENTIFIER){
-    std::unique_ptr<Node> tok(expect(TOK_IDENTIFIER));
+    Token tok = expect(TOK_IDENTIFIER);
     std::unique_ptr<Node> fncall(new Node(AST_FNCALL));
 
     // function reference
     std::unique_ptr<Node> varRef(new Node(AST_VARREF));
-    varRef->set_str(tok->get_str());
-    varRef->set_loc(tok->get_loc());
+    varRef->set_str(tok.get_str());
+    varRef->set_loc(m_lexer->get_loc(tok));
     fncall->append_kid(varRef.release());
 
     // function arguments
@@ -527,34 +921,33 @@ Node *Parser2::parse_F() {
     fncall->append_kid(parse_OptArgList());
     expect_and_discard(TOK_RPAREN);
 
-    tok.release();
     return fncall.release();
   };
 
-  if (tag == TOK_INTEGER_LITERAL || tag == TOK_IDENTIFIER) {
-    // F -> ^ number
-    // F -> ^ ident
-    std::unique_ptr<Node> tok(expect(static_cast<enum TokenKind>(tag)));
-    int ast_tag = tag == TOK_INTEGER_LITERAL ? AST_INT_LITERAL : AST_VARREF;
+  if (tag == TOK_INTEGER_LITERAL || tag == TOK_FLOAT_LITERAL || tag == TOK_IDENTIFIER) {
+    // P -> ^ number
+    // P -> ^ ident
+    Token tok = expect(static_cast<enum TokenKind>(tag));
+    int ast_tag = tag == TOK_INTEGER_LITERAL ? AST_INT_LITERAL : tag == TOK_FLOAT_LITERAL ? AST_FLOAT_LITERAL : AST_VARREF;
     std::unique_ptr<Node> ast(new Node(ast_tag));
-    ast->set_str(tok->get_str());
-    ast->set_loc(tok->get_loc());
+    ast->set_str(tok.get_str());
+    ast->set_loc(m_lexer->get_loc(tok));
     return ast.release();
   } else if (tag == TOK_LPAREN) {
-    // F -> ^ ( E ) DONE - Changed to F -> ^ ( A )
+    // P -> ^ ( A )
     expect_and_discard(TOK_LPAREN);
     std::unique_ptr<Node> ast(parse_A());
     expect_and_discard(TOK_RPAREN);
     return ast.release();
   } else if (tag == TOK_STRING) {
-    // F -> string_literal
-    std::unique_ptr<Node> tok(expect(TOK_STRING));
+    // P -> string_literal
+    Token tok = expect(TOK_STRING);
     std::unique_ptr<Node> ast(new Node(AST_STRING_LITERAL));
-    ast->set_str(tok->get_str());
-    ast->set_loc(tok->get_loc());
+    ast->set_str(tok.get_str());
+    ast->set_loc(m_lexer->get_loc(tok));
     return ast.release();
   } else {
-    SyntaxError::raise(next_tok->get_loc(), "Invalid primary expression");
+    SyntaxError::raise(m_lexer->get_loc(*next_tok), "Invalid primary expression");
   }
 }
 
@@ -563,7 +956,7 @@ Node *Parser2::parse_OptArgList() {
   // OptArgList -> epsilon
   std::unique_ptr<Node> ast(new Node(AST_ARGLIST));
 
-  Node *next_tok = m_lexer->peek(1);
+  const Token *next_tok = m_lexer->peek(1);
   if (next_tok != nullptr && next_tok->get_tag() != TOK_RPAREN) {
     return parse_ArgList(ast.release());
   }
@@ -575,7 +968,7 @@ Node *Parser2::parse_ArgList(Node *ast_) {
   // ArgList -> L , ArgList
   for (;;) {
     ast_->append_kid(parse_L());
-    Node* next_tok = m_lexer->peek(1);
+    const Token *next_tok = m_lexer->peek(1);
     if (next_tok == nullptr || next_tok->get_tag() != TOK_COMMA)
       break;
     else {
@@ -586,17 +979,23 @@ Node *Parser2::parse_ArgList(Node *ast_) {
 }
 
 
-Node *Parser2::expect(enum TokenKind tok_kind) {
-  std::unique_ptr<Node> next_terminal(m_lexer->next());
-  if (next_terminal->get_tag() != tok_kind) {
-    SyntaxError::raise(next_terminal->get_loc(), "Unexpected token '%s'", next_terminal->get_str().c_str());
+Token Parser2::expect(enum TokenKind tok_kind) {
+  Token next_terminal = m_lexer->next();
+  if (next_terminal.get_tag() != tok_kind) {
+    SyntaxError::raise(m_lexer->get_loc(next_terminal), "Unexpected token '%s'", next_terminal.get_str().c_str());
   }
-  return next_terminal.release();
+  return next_terminal;
 }
 
 void Parser2::expect_and_discard(enum TokenKind tok_kind) {
-  Node *tok = expect(tok_kind);
-  delete tok;
+  expect(tok_kind);
+}
+
+void Parser2::check_assignable(Node *ast, const Token &op) {
+  int tag = ast->get_tag();
+  if (tag != AST_VARREF && tag != AST_FIELDREF && tag != AST_INDEX) {
+    SyntaxError::raise(m_lexer->get_loc(op), "Invalid target for '%s'", op.get_str().c_str());
+  }
 }
 
 void Parser2::error_at_current_loc(const std::string &msg) {
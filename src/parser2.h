@@ -8,6 +8,9 @@ class Parser2 {
 private:
   Lexer *m_lexer;
   Node *m_next;
+  int m_loop_depth;     // number of loops enclosing the current statement
+  bool m_in_function;   // whether the current statement is in a function body
+  int m_switch_depth;   // number of switch statements enclosing the current statement
 
 public:
   Parser2(Lexer *lexer_to_adopt);
@@ -24,6 +27,8 @@ private:
   Node *parse_T();
   Node *parse_TPrime(Node *ast);
   Node *parse_F();
+  Node *parse_FPrime(Node *ast);
+  Node *parse_P();
 
   Node *parse_A();
   Node *parse_L();
@@ -39,12 +44,27 @@ private:
   Node *parse_OptPList();
   Node *parse_PList(Node *ast);
 
-  // Consume a specific token, wrapping it in a Node
-  Node *expect(enum TokenKind tok_kind);
+  // Records:
+  Node *parse_Rec();
+
+  // Switch statements:
+  Node *parse_Switch();
+
+  // Bitwise operators:
+  Node *parse_O();
+  Node *parse_X();
+  Node *parse_N();
+  Node *parse_S();
+
+  // Consume a specific token
+  Token expect(enum TokenKind tok_kind);
 
   // Consume a specific token and discard it
   void expect_and_discard(enum TokenKind tok_kind);
 
+  // Report an error if ast can't be the target of the assignment operator op
+  void check_assignable(Node *ast, const Token &op);
+
   // Report an error at current lexer position
   void error_at_current_loc(const std::string &msg);
 
@@ -0,0 +1,96 @@
+#include <utility>
+#include "pqueue.h"
+#include "exceptions.h"
+
+namespace {
+const size_t ARITY = 4;
+}
+
+PriorityQueue::PriorityQueue()
+  : ValRep(VALREP_PQUEUE)
+  , m_seq(0) {
+}
+
+PriorityQueue::~PriorityQueue() {
+}
+
+void PriorityQueue::push(int64_t prio, const Value &val) {
+  m_keys.push_back(make_key(prio, m_seq++));
+  m_values.push_back(val);
+  sift_up(m_keys.size() - 1);
+}
+
+Value PriorityQueue::pop(const Location &location) {
+  if (m_keys.empty()) {
+    EvaluationError::raise(location, "Popping an empty priority queue");
+  }
+  Value top = m_values[0];
+  m_keys[0] = m_keys.back();
+  std::swap(m_values[0], m_values.back());
+  m_keys.pop_back();
+  m_values.pop_back();
+  if (!m_keys.empty()) {
+    sift_down(0);
+  }
+  return top;
+}
+
+Value PriorityQueue::peek(const Location &location) const {
+  if (m_keys.empty()) {
+    EvaluationError::raise(location, "Peeking at an empty priority queue");
+  }
+  return m_values[0];
+}
+
+PriorityQueue::Key PriorityQueue::make_key(int64_t prio, uint64_t seq) {
+  // flipping the sign bit makes unsigned order agree with signed order
+  uint64_t biased = uint64_t(prio) ^ (uint64_t(1) << 63);
+  return (Key(biased) << 64) | seq;
+}
+
+// The sift functions carry the moving key in a local variable and only
+// write it back once it has found its place.
+
+void PriorityQueue::sift_up(size_t i) {
+  Key key = m_keys[i];
+  Value val = m_values[i];
+  while (i > 0) {
+    size_t parent = (i - 1) / ARITY;
+    if (m_keys[parent] <= key) {
+      break;
+    }
+    m_keys[i] = m_keys[parent];
+    std::swap(m_values[i], m_values[parent]);
+    i = parent;
+  }
+  m_keys[i] = key;
+  m_values[i] = val;
+}
+
+void PriorityQueue::sift_down(size_t i) {
+  size_t n = m_keys.size();
+  Key key = m_keys[i];
+  Value val = m_values[i];
+  for (;;) {
+    size_t first = i * ARITY + 1;
+    if (first >= n) {
+      break;
+    }
+    // find the smallest of (up to) four adjacent children
+    size_t last = first + ARITY < n ? first + ARITY : n;
+    size_t min_child = first;
+    for (size_t c = first + 1; c < last; c++) {
+      if (m_keys[c] < m_keys[min_child]) {
+        min_child = c;
+      }
+    }
+    if (key <= m_keys[min_child]) {
+      break;
+    }
+    m_keys[i] = m_keys[min_child];
+    std::swap(m_values[i], m_values[min_child]);
+    i = min_child;
+  }
+  m_keys[i] = key;
+  m_values[i] = val;
+}
@@ -0,0 +1,41 @@
+#ifndef PQUEUE_H
+#define PQUEUE_H
+
+#include <cstdint>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// A min-priority queue, stored as a 4-ary heap.  The heap order is
+// kept in an array of packed 128-bit keys (priority in the high half,
+// insertion sequence number in the low half), so sifting only touches
+// the key array and elements of equal priority come out in FIFO order.
+// The values live in a parallel array and are moved along with their keys.
+class PriorityQueue : public ValRep {
+private:
+  typedef unsigned __int128 Key;
+
+  std::vector<Key> m_keys;
+  std::vector<Value> m_values;
+  uint64_t m_seq;
+
+public:
+  PriorityQueue();
+  virtual ~PriorityQueue();
+
+  int len() const { return int(m_keys.size()); }
+
+  void push(int64_t prio, const Value &val);
+  Value pop(const Location &location);
+  Value peek(const Location &location) const;
+
+private:
+  static Key make_key(int64_t prio, uint64_t seq);
+  void sift_up(size_t i);
+  void sift_down(size_t i);
+};
+
+#endif //PQUEUE_H
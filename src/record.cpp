@@ -0,0 +1,78 @@
+#include "record.h"
+#include "array.h"
+#include "exceptions.h"
+
+int Shape::s_next_id = 1;
+
+Shape::Shape(const std::string &name, const std::vector<std::string> &fields)
+  : ValRep(VALREP_SHAPE)
+  , m_name(name)
+  , m_fields(fields)
+  , m_id(s_next_id++) {
+}
+
+Shape::~Shape() {
+}
+
+int Shape::find_slot(const std::string &field) const {
+  for (int i = 0; i < get_num_fields(); i++) {
+    if (m_fields[i] == field) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+Record::Record(Shape *shape, const std::vector<Value> &slots)
+  : ValRep(VALREP_RECORD)
+  , m_shape(shape)
+  , m_slots(slots) {
+}
+
+Record::~Record() {
+}
+
+RecordArray::RecordArray(Shape *shape, int size)
+  : ValRep(VALREP_RECORD_ARRAY)
+  , m_shape(shape)
+  , m_size(size) {
+  for (int i = 0; i < shape->get_num_fields(); i++) {
+    m_columns.push_back(Value(new Array(std::vector<Value>(size))));
+  }
+}
+
+RecordArray::~RecordArray() {
+}
+
+Value RecordArray::get(int index, const Location &location) const {
+  if (index < 0 || index >= m_size) {
+    EvaluationError::raise(location, "Record array index out of bound: %d", index);
+  }
+  std::vector<Value> slots;
+  for (auto i = m_columns.begin(); i != m_columns.end(); ++i) {
+    slots.push_back(i->get_array()->get(index, location));
+  }
+  return Value(new Record(get_shape(), slots));
+}
+
+Value *RecordArray::field_at(int slot, int index, const Location &location) {
+  if (index < 0 || index >= m_size) {
+    EvaluationError::raise(location, "Record array index out of bound: %d", index);
+  }
+  return m_columns[slot].get_array()->at(index, location);
+}
+
+Value RecordArray::set(int index, const Value &val, const Location &location) {
+  if (index < 0 || index >= m_size) {
+    EvaluationError::raise(location, "Record array index out of bound: %d", index);
+  }
+  if (val.get_kind() != VALUE_RECORD || val.get_record()->get_shape() != get_shape()) {
+    EvaluationError::raise(location, "%s", ("Value stored in a record array must be a " +
+                                            get_shape()->get_name() + " record").c_str());
+  }
+  Record *record = val.get_record();
+  for (int i = 0; i < int(m_columns.size()); i++) {
+    m_columns[i].get_array()->set(index, record->get(i), location);
+  }
+  return val;
+}
@@ -0,0 +1,79 @@
+#ifndef RECORD_H
+#define RECORD_H
+
+#include <string>
+#include <vector>
+#include "valrep.h"
+#include "value.h"
+
+class Value;
+class Location;
+
+// The shape (layout) of a record type declared with
+//   record Name { field, ... }
+// Each field is stored at a fixed slot.  Calling a Shape as a function
+// constructs a record.  Every Shape has a unique id, which field
+// access nodes use to cache the slot of the last shape they saw.
+class Shape : public ValRep {
+private:
+  std::string m_name;
+  std::vector<std::string> m_fields;
+  int m_id;
+
+  static int s_next_id;
+
+public:
+  Shape(const std::string &name, const std::vector<std::string> &fields);
+  virtual ~Shape();
+
+  const std::string &get_name() const { return m_name; }
+  int get_id() const { return m_id; }
+  int get_num_fields() const { return int(m_fields.size()); }
+  const std::string &get_field_name(int slot) const { return m_fields[slot]; }
+
+  // Slot of the named field, or -1 if there is no such field
+  int find_slot(const std::string &field) const;
+};
+
+// An instance of a record type
+class Record : public ValRep {
+private:
+  Value m_shape;
+  std::vector<Value> m_slots;
+
+public:
+  Record(Shape *shape, const std::vector<Value> &slots);
+  virtual ~Record();
+
+  Shape *get_shape() const { return m_shape.get_shape(); }
+  const Value &get(int slot) const { return m_slots[slot]; }
+  Value set(int slot, const Value &val) { m_slots[slot] = val; return val; }
+  Value *at(int slot) { return &m_slots[slot]; }
+};
+
+// An array of records, stored as a structure of arrays: one Array
+// per field.  Accessing a field of a RecordArray yields that field's
+// Array, so a scan over a single field touches only that field's values.
+class RecordArray : public ValRep {
+private:
+  Value m_shape;
+  std::vector<Value> m_columns;
+  int m_size;
+
+public:
+  RecordArray(Shape *shape, int size);
+  virtual ~RecordArray();
+
+  Shape *get_shape() const { return m_shape.get_shape(); }
+  int len() const { return m_size; }
+  const Value &column(int slot) const { return m_columns[slot]; }
+
+  // storage of one field of one record, in that field's column
+  Value *field_at(int slot, int index, const Location &location);
+
+  // gather/scatter a single record
+  Value get(int index, const Location &location) const;
+  Value set(int index, const Value &val, const Location &location);
+};
+
+#endif //RECORD_H
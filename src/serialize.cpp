@@ -0,0 +1,335 @@
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include "serialize.h"
+#include "valrep.h"
+#include "array.h"
+#include "string.h"
+#include "bytes.h"
+#include "map.h"
+#include "bigint.h"
+#include "outbuf.h"
+#include "exceptions.h"
+
+namespace {
+
+const char MAGIC[4] = { 'M', 'L', 'S', '1' };
+
+// Arrays and maps are written and read recursively, so they may only be
+// nested this deeply (a crafted input could otherwise overflow the stack)
+const int MAX_DEPTH = 1000;
+
+enum Tag {
+  TAG_INT,
+  TAG_DOUBLE,
+  TAG_BIGINT,
+  TAG_STRING,
+  TAG_BYTES,
+  TAG_ARRAY,
+  TAG_MAP,
+  TAG_REF,
+};
+
+// Writes values to a sink, a function taking (const char *, size_t)
+template<typename Sink>
+class Writer {
+private:
+  Sink m_sink;
+  const Location &m_loc;
+  std::unordered_map<const ValRep *, uint64_t> m_objects;
+  int m_depth;
+
+  void enter() {
+    if (++m_depth > MAX_DEPTH) {
+      EvaluationError::raise(m_loc, "Value nested too deeply to serialize (more than %d levels)", MAX_DEPTH);
+    }
+  }
+
+public:
+  Writer(Sink sink, const Location &loc) : m_sink(sink), m_loc(loc), m_depth(0) { }
+
+  void put(const void *data, size_t len) {
+    m_sink(static_cast<const char *>(data), len);
+  }
+
+  void put_varint(uint64_t n) {
+    char buf[10];
+    size_t len = 0;
+    while (n >= 0x80) {
+      buf[len++] = char(n | 0x80);
+      n >>= 7;
+    }
+    buf[len++] = char(n);
+    put(buf, len);
+  }
+
+  void put_tag(Tag tag) {
+    char c = char(tag);
+    put(&c, 1);
+  }
+
+  void put_le(uint64_t n, size_t len) {
+    char buf[8];
+    for (size_t i = 0; i < len; i++) {
+      buf[i] = char(n >> (8 * i));
+    }
+    put(buf, len);
+  }
+
+  // Write a ref if the object has already been written; otherwise
+  // give it the next number
+  bool put_ref(const ValRep *rep) {
+    auto i = m_objects.find(rep);
+    if (i != m_objects.end()) {
+      put_tag(TAG_REF);
+      put_varint(i->second);
+      return true;
+    }
+    uint64_t number = m_objects.size();
+    m_objects[rep] = number;
+    return false;
+  }
+
+  void write(const Value &val) {
+    switch (val.get_kind()) {
+      case VALUE_INT: {
+        int64_t ival = val.get_ival();
+        put_tag(TAG_INT);
+        put_varint((uint64_t(ival) << 1) ^ uint64_t(ival >> 63));
+        break;
+      }
+      case VALUE_DOUBLE: {
+        double dval = val.get_dval();
+        uint64_t bits;
+        memcpy(&bits, &dval, sizeof(bits));
+        put_tag(TAG_DOUBLE);
+        put_le(bits, 8);
+        break;
+      }
+      case VALUE_BIGINT: {
+        BigInt *big = val.get_bigint();
+        put_tag(TAG_BIGINT);
+        put_le(big->is_negative() ? 1 : 0, 1);
+        put_varint(big->get_mag().size());
+        for (uint32_t limb : big->get_mag()) {
+          put_le(limb, 4);
+        }
+        break;
+      }
+      case VALUE_STRING: {
+        String *str = val.get_string();
+        if (!put_ref(str)) {
+          put_tag(TAG_STRING);
+          put_varint(size_t(str->strlen()));
+          put(str->data(), size_t(str->strlen()));
+        }
+        break;
+      }
+      case VALUE_BYTES: {
+        Bytes *bytes = val.get_bytes();
+        if (!put_ref(bytes)) {
+          put_tag(TAG_BYTES);
+          put_varint(size_t(bytes->len()));
+          put(bytes->data(), size_t(bytes->len()));
+        }
+        break;
+      }
+      case VALUE_ARRAY: {
+        Array *arr = val.get_array();
+        if (!put_ref(arr)) {
+          put_tag(TAG_ARRAY);
+          put_varint(size_t(arr->len()));
+          enter();
+          for (int i = 0; i < arr->len(); i++) {
+            write(*arr->at(i, m_loc));
+          }
+          m_depth--;
+        }
+        break;
+      }
+      case VALUE_MAP: {
+        Map *map = val.get_map();
+        if (!put_ref(map)) {
+          put_tag(TAG_MAP);
+          put_varint(size_t(map->len()));
+          enter();
+          map->each_entry([this](const Value &key, const Value &value) {
+            write(key);
+            write(value);
+          });
+          m_depth--;
+        }
+        break;
+      }
+      default:
+        EvaluationError::raise(m_loc, "Only ints, floats, strings, bytes, arrays and maps can be serialized");
+    }
+  }
+};
+
+template<typename Sink>
+void serialize_to(const Value &val, Sink sink, const Location &loc) {
+  Writer<Sink> writer(sink, loc);
+  writer.put(MAGIC, sizeof(MAGIC));
+  writer.write(val);
+}
+
+class Reader {
+private:
+  const unsigned char *m_pos, *m_end;
+  const Location &m_loc;
+  std::vector<Value> m_objects;
+  int m_depth;
+
+  [[noreturn]] void malformed() {
+    EvaluationError::raise(m_loc, "Malformed serialized data");
+  }
+
+  void enter() {
+    if (++m_depth > MAX_DEPTH) {
+      malformed();
+    }
+  }
+
+public:
+  Reader(const unsigned char *data, size_t len, const Location &loc)
+    : m_pos(data), m_end(data + len), m_loc(loc), m_depth(0) { }
+
+  bool at_end() const { return m_pos == m_end; }
+
+  const unsigned char *get(size_t len) {
+    if (size_t(m_end - m_pos) < len) {
+      malformed();
+    }
+    const unsigned char *data = m_pos;
+    m_pos += len;
+    return data;
+  }
+
+  uint64_t get_varint() {
+    uint64_t n = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      unsigned char c = *get(1);
+      n |= uint64_t(c & 0x7f) << shift;
+      if ((c & 0x80) == 0) {
+        return n;
+      }
+    }
+    malformed();
+  }
+
+  // A length or count, which can't be more than the remaining bytes
+  size_t get_len() {
+    uint64_t len = get_varint();
+    if (len > uint64_t(m_end - m_pos)) {
+      malformed();
+    }
+    return size_t(len);
+  }
+
+  uint64_t get_le(size_t len) {
+    const unsigned char *data = get(len);
+    uint64_t n = 0;
+    for (size_t i = 0; i < len; i++) {
+      n |= uint64_t(data[i]) << (8 * i);
+    }
+    return n;
+  }
+
+  Value read() {
+    switch (*get(1)) {
+      case TAG_INT: {
+        uint64_t n = get_varint();
+        return Value(int64_t((n >> 1) ^ (0 - (n & 1))));
+      }
+      case TAG_DOUBLE: {
+        uint64_t bits = get_le(8);
+        double dval;
+        memcpy(&dval, &bits, sizeof(dval));
+        return Value(dval);
+      }
+      case TAG_BIGINT: {
+        bool negative = get_le(1) != 0;
+        std::vector<uint32_t> mag(get_len());
+        for (size_t i = 0; i < mag.size(); i++) {
+          mag[i] = uint32_t(get_le(4));
+        }
+        // rebuild it with arithmetic, so it is normalized
+        Value val = BigInt::add(Value(new BigInt(false, mag)), Value(0));
+        return negative ? BigInt::sub(Value(0), val) : val;
+      }
+      case TAG_STRING: {
+        size_t len = get_len();
+        const char *data = reinterpret_cast<const char *>(get(len));
+        m_objects.push_back(Value(new String(std::string(data, len))));
+        return m_objects.back();
+      }
+      case TAG_BYTES: {
+        size_t len = get_len();
+        const char *data = reinterpret_cast<const char *>(get(len));
+        m_objects.push_back(Value(new Bytes(data, len)));
+        return m_objects.back();
+      }
+      case TAG_ARRAY: {
+        size_t count = get_len();
+        // number the array before reading its elements, which may refer to it
+        Value arr(new Array(std::vector<Value>()));
+        m_objects.push_back(arr);
+        enter();
+        for (size_t i = 0; i < count; i++) {
+          arr.get_array()->push(read());
+        }
+        m_depth--;
+        return arr;
+      }
+      case TAG_MAP: {
+        size_t count = get_len();
+        Value map(new Map());
+        m_objects.push_back(map);
+        enter();
+        for (size_t i = 0; i < count; i++) {
+          Value key = read();
+          Value value = read();
+          map.get_map()->put(key, value, m_loc);
+        }
+        m_depth--;
+        return map;
+      }
+      case TAG_REF: {
+        uint64_t number = get_varint();
+        if (number >= m_objects.size()) {
+          malformed();
+        }
+        return m_objects[number];
+      }
+      default:
+        malformed();
+    }
+  }
+};
+
+}
+
+namespace serialutil {
+
+void serialize(const Value &val, Bytes *out, const Location &loc) {
+  serialize_to(val, [out](const char *data, size_t len) { out->append(data, len); }, loc);
+}
+
+void serialize(const Value &val, OutputBuffer &out, const Location &loc) {
+  serialize_to(val, [&out](const char *data, size_t len) { out.write(data, len); }, loc);
+}
+
+Value deserialize(const unsigned char *data, size_t len, const Location &loc) {
+  if (len < sizeof(MAGIC) || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+    EvaluationError::raise(loc, "Not serialized data");
+  }
+  Reader reader(data + sizeof(MAGIC), len - sizeof(MAGIC), loc);
+  Value val = reader.read();
+  if (!reader.at_end()) {
+    EvaluationError::raise(loc, "Malformed serialized data");
+  }
+  return val;
+}
+
+}
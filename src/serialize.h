@@ -0,0 +1,42 @@
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <cstddef>
+#include "value.h"
+
+class Bytes;
+class OutputBuffer;
+class Location;
+
+// Binary serialization used by the serialize and deserialize intrinsics.
+//
+// The format is a 4-byte magic number followed by one value.  Each value
+// is a tag byte followed by its contents, with lengths and counts as
+// LEB128 varints:
+//
+//   int     zigzag-encoded varint
+//   double  8 bytes, little-endian
+//   bigint  sign byte, limb count, 4-byte little-endian limbs
+//   string  length, bytes
+//   bytes   length, bytes
+//   array   count, elements
+//   map     count, key/value pairs
+//   ref     object number
+//
+// Strings, bytes, arrays and maps are numbered in the order they are
+// written, and an object that has already been written is written as a
+// ref to its number, so shared substructure and cycles are preserved.
+// Arrays and maps may be nested at most 1000 deep.
+
+namespace serialutil {
+
+// Append the serialized form of val to out
+void serialize(const Value &val, Bytes *out, const Location &loc);
+void serialize(const Value &val, OutputBuffer &out, const Location &loc);
+
+// The value serialized in data
+Value deserialize(const unsigned char *data, size_t len, const Location &loc);
+
+}
+
+#endif // SERIALIZE_H
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include "sort.h"
+
+namespace {
+
+// Below this size, std::sort beats the fixed cost of the radix passes
+const size_t RADIX_THRESHOLD = 256;
+
+// Inputs at least this large are sorted in parallel
+const size_t PARALLEL_THRESHOLD = 1 << 18;
+
+// LSD radix sort of [begin, end) using 8-bit digits, with buf as scratch
+// space of the same size.  Passes in which every key has the same digit
+// are skipped, so small ranges of values take fewer passes.
+void radix_sort(int64_t *begin, int64_t *end, int64_t *buf) {
+  size_t n = size_t(end - begin);
+  if (n < RADIX_THRESHOLD) {
+    std::sort(begin, end);
+    return;
+  }
+
+  // flipping the sign bit makes unsigned order agree with signed order
+  const uint64_t FLIP = uint64_t(1) << 63;
+
+  // histograms for all eight digits, computed in a single pass
+  size_t counts[8][256] = {};
+  for (size_t i = 0; i < n; i++) {
+    uint64_t key = uint64_t(begin[i]) ^ FLIP;
+    for (int d = 0; d < 8; d++) {
+      counts[d][(key >> (d * 8)) & 0xff]++;
+    }
+  }
+
+  int64_t *src = begin, *dst = buf;
+  for (int pass = 0; pass < 8; pass++) {
+    unsigned shift = pass * 8;
+    size_t *count = counts[pass];
+    if (count[(uint64_t(src[0]) ^ FLIP) >> shift & 0xff] == n) {
+      continue;
+    }
+    size_t offset[256], sum = 0;
+    for (int d = 0; d < 256; d++) {
+      offset[d] = sum;
+      sum += count[d];
+    }
+    for (size_t i = 0; i < n; i++) {
+      uint64_t key = uint64_t(src[i]) ^ FLIP;
+      dst[offset[(key >> shift) & 0xff]++] = src[i];
+    }
+    std::swap(src, dst);
+  }
+  if (src != begin) {
+    std::copy(src, src + n, begin);
+  }
+}
+
+}
+
+void sortutil::sort_ints(std::vector<int64_t> &v) {
+  size_t n = v.size();
+  std::vector<int64_t> buf(n);
+
+  unsigned nthreads = std::thread::hardware_concurrency();
+  if (n < PARALLEL_THRESHOLD || nthreads < 2) {
+    radix_sort(v.data(), v.data() + n, buf.data());
+    return;
+  }
+
+  // radix sort equal-sized chunks in parallel...
+  nthreads = std::min(nthreads, 16U);
+  std::vector<size_t> bounds;
+  for (unsigned t = 0; t <= nthreads; t++) {
+    bounds.push_back(n * t / nthreads);
+  }
+  std::vector<std::thread> threads;
+  for (unsigned t = 0; t < nthreads; t++) {
+    int64_t *begin = v.data() + bounds[t], *end = v.data() + bounds[t + 1];
+    int64_t *scratch = buf.data() + bounds[t];
+    threads.emplace_back([begin, end, scratch]() { radix_sort(begin, end, scratch); });
+  }
+  for (auto &t : threads) {
+    t.join();
+  }
+
+  // ...then merge adjacent pairs of sorted chunks, also in parallel,
+  // until a single chunk remains
+  int64_t *src = v.data(), *dst = buf.data();
+  while (bounds.size() > 2) {
+    std::vector<size_t> merged_bounds;
+    threads.clear();
+    for (size_t c = 0; c + 1 < bounds.size(); c += 2) {
+      size_t lo = bounds[c];
+      size_t mid = bounds[c + 1];
+      size_t hi = c + 2 < bounds.size() ? bounds[c + 2] : mid;
+      merged_bounds.push_back(lo);
+      threads.emplace_back([src, dst, lo, mid, hi]() {
+        std::merge(src + lo, src + mid, src + mid, src + hi, dst + lo);
+      });
+    }
+    merged_bounds.push_back(n);
+    for (auto &t : threads) {
+      t.join();
+    }
+    bounds.swap(merged_bounds);
+    std::swap(src, dst);
+  }
+  if (src != v.data()) {
+    std::copy(src, src + n, v.data());
+  }
+}
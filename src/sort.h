@@ -0,0 +1,70 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Sorting routines used by the sort and sortby intrinsics
+
+namespace sortutil {
+
+// Sort ints in ascending order: a radix sort, which is split
+// across threads for large inputs
+void sort_ints(std::vector<int64_t> &v);
+
+// Stable merge sort.  Unlike std::stable_sort, it never reads outside
+// the vector even if less() is not a strict weak ordering, which matters
+// because the comparison may be a user-defined function.
+template<typename T, typename Less>
+void merge_sort(std::vector<T> &v, Less less) {
+  const size_t RUN = 16;
+  size_t n = v.size();
+
+  // insertion sort short runs
+  for (size_t lo = 0; lo < n; lo += RUN) {
+    size_t hi = lo + RUN < n ? lo + RUN : n;
+    for (size_t i = lo + 1; i < hi; i++) {
+      T x = v[i];
+      size_t j = i;
+      while (j > lo && less(x, v[j - 1])) {
+        v[j] = v[j - 1];
+        j--;
+      }
+      v[j] = x;
+    }
+  }
+
+  // merge pairs of runs, alternating between v and buf
+  std::vector<T> buf(n);
+  std::vector<T> *src = &v, *dst = &buf;
+  for (size_t width = RUN; width < n; width *= 2) {
+    for (size_t lo = 0; lo < n; lo += 2 * width) {
+      size_t mid = lo + width < n ? lo + width : n;
+      size_t hi = lo + 2 * width < n ? lo + 2 * width : n;
+      size_t i = lo, j = mid, k = lo;
+      while (i < mid && j < hi) {
+        // take from the right run only if strictly less, for stability
+        if (less((*src)[j], (*src)[i])) {
+          (*dst)[k++] = (*src)[j++];
+        } else {
+          (*dst)[k++] = (*src)[i++];
+        }
+      }
+      while (i < mid) {
+        (*dst)[k++] = (*src)[i++];
+      }
+      while (j < hi) {
+        (*dst)[k++] = (*src)[j++];
+      }
+    }
+    std::swap(src, dst);
+  }
+  if (src != &v) {
+    v.swap(buf);
+  }
+}
+
+}
+
+#endif // SORT_H
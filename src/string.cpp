@@ -1,24 +1,177 @@
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include "string.h"
+#include "array.h"
 #include "exceptions.h"
 
+namespace {
+// Substrings no longer than this are copied rather than sliced:
+// they fit in std::string's inline buffer, and copying them
+// avoids keeping a (possibly large) base String alive.
+const size_t MIN_SLICE_LEN = 16;
+
+const char *find_bytes(const char *hay, size_t hay_len, const char *needle, size_t needle_len) {
+  if (needle_len == 1) {
+    return static_cast<const char *>(memchr(hay, needle[0], hay_len));
+  }
+  // glibc's memmem uses the two-way algorithm (with a vectorized
+  // first-byte scan), so it is linear in the length of the haystack
+  return static_cast<const char *>(memmem(hay, hay_len, needle, needle_len));
+}
+}
+
 String::String(std::string a_string)
   : ValRep(VALREP_STRING)
-  , m_string(a_string) {
+  , m_string(a_string)
+  , m_data(m_string.data())
+  , m_len(m_string.length())
+  , m_hash(0)
+  , m_hash_valid(false) {
+}
+
+String::String(String *base, const char *data, size_t len)
+  : ValRep(VALREP_STRING)
+  , m_base(base)
+  , m_data(data)
+  , m_len(len)
+  , m_hash(0)
+  , m_hash_valid(false) {
+}
+
+String::String(const std::shared_ptr<const char> &storage, const char *data, size_t len)
+  : ValRep(VALREP_STRING)
+  , m_storage(storage)
+  , m_data(data)
+  , m_len(len)
+  , m_hash(0)
+  , m_hash_valid(false) {
 }
 
 String::~String() {
 }
 
-Value String::substr(int start, int end, Location loc) const {
-  return Value(new String(m_string.substr(start, end)));
+Value String::substr(int start, int end, Location loc) {
+  // note that (like std::string::substr) the second argument is
+  // the length of the substring, which is clamped to the end of the string
+  if (start < 0 || size_t(start) > m_len) {
+    EvaluationError::raise(loc, "String index out of bound: %d", start);
+  }
+  if (end < 0) {
+    EvaluationError::raise(loc, "Negative substring length: %d", end);
+  }
+  return slice(start, std::min(size_t(end), m_len - start));
 }
 
 Value String::strcat(Value b_string) const {
-  std::string b = b_string.get_string()->m_string;
-  return Value(new String(m_string + b));
+  String *b = b_string.get_string();
+  std::string result;
+  result.reserve(m_len + b->m_len);
+  result.append(m_data, m_len);
+  result.append(b->m_data, b->m_len);
+  return Value(new String(result));
 }
 
 std::string String::get_actual_string() {
-  return m_string;
+  return std::string(m_data, m_len);
 }
 
+size_t String::hash() const {
+  if (!m_hash_valid) {
+    // 64-bit FNV-1a
+    size_t h = 14695981039346656037UL;
+    for (size_t i = 0; i < m_len; i++) {
+      h ^= (unsigned char) m_data[i];
+      h *= 1099511628211UL;
+    }
+    m_hash = h;
+    m_hash_valid = true;
+  }
+  return m_hash;
+}
+
+int String::compare(const String *other) const {
+  if (this == other) {
+    return 0;
+  }
+  size_t len = m_len, other_len = other->m_len;
+  int cmp = memcmp(m_data, other->m_data, std::min(len, other_len));
+  if (cmp != 0) {
+    return cmp;
+  }
+  return len < other_len ? -1 : (len > other_len ? 1 : 0);
+}
+
+bool String::equals(const String *other) const {
+  if (this == other) {
+    // interned strings (and copies of the same Value) are identical
+    return true;
+  }
+  if (m_len != other->m_len) {
+    return false;
+  }
+  // only use the hashes if both are already known
+  if (m_hash_valid && other->m_hash_valid && m_hash != other->m_hash) {
+    return false;
+  }
+  return memcmp(m_data, other->m_data, m_len) == 0;
+}
+
+int String::find(const String *needle, int start) const {
+  if (start < 0) {
+    start = 0;
+  }
+  if (size_t(start) > m_len) {
+    return -1;
+  }
+  if (needle->m_len == 0) {
+    return start;
+  }
+  const char *p = find_bytes(m_data + start, m_len - start, needle->m_data, needle->m_len);
+  return p ? int(p - m_data) : -1;
+}
+
+int String::count(const String *needle) const {
+  assert(needle->m_len > 0);
+  int n = 0;
+  const char *p = m_data, *end = m_data + m_len;
+  while ((p = find_bytes(p, end - p, needle->m_data, needle->m_len)) != nullptr) {
+    n++;
+    p += needle->m_len;
+  }
+  return n;
+}
+
+Value String::split(const String *sep) {
+  assert(sep->m_len > 0);
+  std::vector<Value> pieces;
+  const char *p = m_data, *end = m_data + m_len;
+  for (;;) {
+    const char *q = find_bytes(p, end - p, sep->m_data, sep->m_len);
+    if (q == nullptr) {
+      pieces.push_back(slice(p - m_data, end - p));
+      break;
+    }
+    pieces.push_back(slice(p - m_data, q - p));
+    p = q + sep->m_len;
+  }
+  return Value(new Array(pieces));
+}
+
+Value String::slice(size_t start, size_t len) {
+  assert(start + len <= m_len);
+  if (len < MIN_SLICE_LEN) {
+    return Value(new String(std::string(m_data + start, len)));
+  }
+  // slices always refer to the String owning the storage,
+  // never to another slice
+  String *base = m_base.get_kind() == VALUE_STRING ? m_base.get_string() : this;
+  return Value(new String(base, m_data + start, len));
+}
+
+Value String::view(const std::shared_ptr<const char> &storage, const char *data, size_t len) {
+  if (len < MIN_SLICE_LEN) {
+    return Value(new String(std::string(data, len)));
+  }
+  return Value(new String(storage, data, len));
+}
@@ -5,6 +5,8 @@
 #ifndef STRING_H
 #define STRING_H
 
+#include <cstddef>
+#include <memory>
 #include "valrep.h"
 #include "value.h"
 
@@ -14,17 +16,53 @@ class Location;
 class String : public ValRep {
   private:
     std::string m_string;
+    // A String is either the owner of its contents (m_string),
+    // or a zero-copy slice of another String (m_base), in which
+    // case m_data points into the base String's storage, or a view
+    // of storage shared with other Strings (m_storage), such as an
+    // input buffer.
+    Value m_base;
+    std::shared_ptr<const char> m_storage;
+    const char *m_data;
+    size_t m_len;
+    // hash of the contents, computed on first use (strings are immutable)
+    mutable size_t m_hash;
+    mutable bool m_hash_valid;
+
+    String(String *base, const char *data, size_t len);
+    String(const std::shared_ptr<const char> &storage, const char *data, size_t len);
 
   public:
     String(std::string a_string);
     virtual ~String();
 
-    Value substr(int start, int end, Location loc) const;
+    Value substr(int start, int end, Location loc);
     Value strcat(Value b_string) const;
     int strlen() const {
-      return m_string.length();
+      return int(m_len);
     };
+    const char *data() const { return m_data; }
     std::string get_actual_string();
+
+    size_t hash() const;
+
+    // Byte-wise comparison: negative, zero, or positive, like memcmp
+    int compare(const String *other) const;
+    bool equals(const String *other) const;
+
+    // Index of the first occurrence of needle at or after start, or -1
+    int find(const String *needle, int start) const;
+    // Number of non-overlapping occurrences of a (non-empty) needle
+    int count(const String *needle) const;
+    // Array of the pieces between occurrences of a (non-empty) separator;
+    // the pieces are slices of this String
+    Value split(const String *sep);
+
+    // Zero-copy substring (the caller checks the bounds)
+    Value slice(size_t start, size_t len);
+
+    // Zero-copy String of len bytes at data, which storage keeps alive
+    static Value view(const std::shared_ptr<const char> &storage, const char *data, size_t len);
 };
 
 
@@ -1,6 +1,9 @@
 #ifndef TOKEN_H
 #define TOKEN_H
 
+#include <cstdint>
+#include <string>
+
 // This header file defines the tags used for tokens (i.e., terminal
 // symbols in the grammar.)
 
@@ -35,6 +38,47 @@ enum TokenKind {
   TOK_COMMA,        // ,
   TOK_FUNCTION,     // function
   TOK_STRING,       // "xxx"
+  TOK_RECORD,       // record
+  TOK_DOT,          // .
+  TOK_LBRACKET,     // [
+  TOK_RBRACKET,     // ]
+  TOK_PLUS_ASSIGN,  // +=
+  TOK_MINUS_ASSIGN, // -=
+  TOK_TIMES_ASSIGN, // *=
+  TOK_DIVIDE_ASSIGN,// /=
+  TOK_INCREMENT,    // ++
+  TOK_DECREMENT,    // --
+  TOK_FOR,          // for
+  TOK_IN,           // in
+  TOK_DOTDOT,       // ..
+  TOK_BREAK,        // break
+  TOK_CONTINUE,     // continue
+  TOK_RETURN,       // return
+  TOK_SWITCH,       // switch
+  TOK_CASE,         // case
+  TOK_DEFAULT,      // default
+  TOK_COLON,        // :
+  TOK_FLOAT_LITERAL,// 1.5, 2e10
+  TOK_MOD,          // %
+  TOK_BITAND,       // &
+  TOK_BITOR,        // |
+  TOK_BITXOR,       // ^
+  TOK_SHIFT_LEFT,   // <<
+  TOK_SHIFT_RIGHT,  // >>
+};
+
+// A token scanned by the Lexer.  Tokens are plain values, so they can be
+// copied freely and lookahead needs no allocation; the parser makes AST
+// nodes only from the tokens that end up in the tree.  The lexeme is a
+// span of text owned by the Lexer, valid for as long as the Lexer is.
+struct Token {
+  const char *start;
+  uint32_t len;
+  uint32_t kind;
+  uint32_t line, col;
+
+  int get_tag() const { return int(kind); }
+  std::string get_str() const { return std::string(start, len); }
 };
 
 #endif // TOKEN_H
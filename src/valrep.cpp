@@ -2,6 +2,16 @@
 #include "valrep.h"
 #include "array.h"
 #include "string.h"
+#include "bytes.h"
+#include "map.h"
+#include "bitset.h"
+#include "deque.h"
+#include "pqueue.h"
+#include "matrix.h"
+#include "record.h"
+#include "bigint.h"
+#include "file.h"
+#include "mappedarray.h"
 
 ValRep::ValRep(ValRepKind kind)
   : m_kind(kind)
@@ -24,4 +34,64 @@ Array *ValRep::as_array() {
 String *ValRep::as_string() {
   assert(m_kind == VALREP_STRING);
   return static_cast<String *>(this);
+}
+
+Bytes *ValRep::as_bytes() {
+  assert(m_kind == VALREP_BYTES);
+  return static_cast<Bytes *>(this);
+}
+
+Map *ValRep::as_map() {
+  assert(m_kind == VALREP_MAP);
+  return static_cast<Map *>(this);
+}
+
+Bitset *ValRep::as_bitset() {
+  assert(m_kind == VALREP_BITSET);
+  return static_cast<Bitset *>(this);
+}
+
+Deque *ValRep::as_deque() {
+  assert(m_kind == VALREP_DEQUE);
+  return static_cast<Deque *>(this);
+}
+
+PriorityQueue *ValRep::as_pqueue() {
+  assert(m_kind == VALREP_PQUEUE);
+  return static_cast<PriorityQueue *>(this);
+}
+
+Matrix *ValRep::as_matrix() {
+  assert(m_kind == VALREP_MATRIX);
+  return static_cast<Matrix *>(this);
+}
+
+Shape *ValRep::as_shape() {
+  assert(m_kind == VALREP_SHAPE);
+  return static_cast<Shape *>(this);
+}
+
+Record *ValRep::as_record() {
+  assert(m_kind == VALREP_RECORD);
+  return static_cast<Record *>(this);
+}
+
+RecordArray *ValRep::as_record_array() {
+  assert(m_kind == VALREP_RECORD_ARRAY);
+  return static_cast<RecordArray *>(this);
+}
+
+BigInt *ValRep::as_bigint() {
+  assert(m_kind == VALREP_BIGINT);
+  return static_cast<BigInt *>(this);
+}
+
+File *ValRep::as_file() {
+  assert(m_kind == VALREP_FILE);
+  return static_cast<File *>(this);
+}
+
+MappedArray *ValRep::as_mapped_array() {
+  assert(m_kind == VALREP_MAPPED_ARRAY);
+  return static_cast<MappedArray *>(this);
 }
\ No newline at end of file
@@ -6,6 +6,18 @@
 class Function;
 class Array;
 class String;
+class Bytes;
+class Map;
+class Bitset;
+class Deque;
+class PriorityQueue;
+class Matrix;
+class Shape;
+class Record;
+class RecordArray;
+class BigInt;
+class File;
+class MappedArray;
 
 // A "ValRep" (value representation) is a type used as
 // a dynamically-allocated object serving as the representation
@@ -16,7 +28,19 @@ enum ValRepKind {
   VALREP_FUNCTION,
   // other kinds of valreps (e.g., vector, string, etc.) could be added
   VALREP_ARRAY,
-  VALREP_STRING
+  VALREP_STRING,
+  VALREP_BYTES,
+  VALREP_MAP,
+  VALREP_BITSET,
+  VALREP_DEQUE,
+  VALREP_PQUEUE,
+  VALREP_MATRIX,
+  VALREP_SHAPE,
+  VALREP_RECORD,
+  VALREP_RECORD_ARRAY,
+  VALREP_BIGINT,
+  VALREP_FILE,
+  VALREP_MAPPED_ARRAY
 };
 
 class ValRep {
@@ -52,6 +76,18 @@ public:
   Function *as_function();
   Array *as_array();
   String *as_string();
+  Bytes *as_bytes();
+  Map *as_map();
+  Bitset *as_bitset();
+  Deque *as_deque();
+  PriorityQueue *as_pqueue();
+  Matrix *as_matrix();
+  Shape *as_shape();
+  Record *as_record();
+  RecordArray *as_record_array();
+  BigInt *as_bigint();
+  File *as_file();
+  MappedArray *as_mapped_array();
 };
 
 #endif
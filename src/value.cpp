@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
 #include "cpputil.h"
 #include "exceptions.h"
 #include "valrep.h"
@@ -5,12 +9,32 @@
 #include "value.h"
 #include "array.h"
 #include "string.h"
+#include "bytes.h"
+#include "map.h"
+#include "bitset.h"
+#include "deque.h"
+#include "pqueue.h"
+#include "matrix.h"
+#include "record.h"
+#include "bigint.h"
+#include "file.h"
+#include "mappedarray.h"
 
 Value::Value(int ival)
   : m_kind(VALUE_INT) {
   m_atomic.ival = ival;
 }
 
+Value::Value(int64_t ival)
+  : m_kind(VALUE_INT) {
+  m_atomic.ival = ival;
+}
+
+Value::Value(double dval)
+  : m_kind(VALUE_DOUBLE) {
+  m_atomic.dval = dval;
+}
+
 Value::Value(Function *fn)
   : m_kind(VALUE_FUNCTION)
   , m_rep(fn) {
@@ -37,6 +61,78 @@ Value::Value(String *str)
   m_rep->add_ref();
 }
 
+Value::Value(Bytes *bytes)
+  : m_kind(VALUE_BYTES)
+  , m_rep(bytes) {
+  m_rep->add_ref();
+}
+
+Value::Value(Map *map)
+  : m_kind(VALUE_MAP)
+  , m_rep(map) {
+  m_rep->add_ref();
+}
+
+Value::Value(Bitset *bitset)
+  : m_kind(VALUE_BITSET)
+  , m_rep(bitset) {
+  m_rep->add_ref();
+}
+
+Value::Value(Deque *deque)
+  : m_kind(VALUE_DEQUE)
+  , m_rep(deque) {
+  m_rep->add_ref();
+}
+
+Value::Value(PriorityQueue *pqueue)
+  : m_kind(VALUE_PQUEUE)
+  , m_rep(pqueue) {
+  m_rep->add_ref();
+}
+
+Value::Value(Matrix *matrix)
+  : m_kind(VALUE_MATRIX)
+  , m_rep(matrix) {
+  m_rep->add_ref();
+}
+
+Value::Value(Shape *shape)
+  : m_kind(VALUE_SHAPE)
+  , m_rep(shape) {
+  m_rep->add_ref();
+}
+
+Value::Value(Record *record)
+  : m_kind(VALUE_RECORD)
+  , m_rep(record) {
+  m_rep->add_ref();
+}
+
+Value::Value(RecordArray *record_array)
+  : m_kind(VALUE_RECORD_ARRAY)
+  , m_rep(record_array) {
+  m_rep->add_ref();
+}
+
+Value::Value(BigInt *bigint)
+  : m_kind(VALUE_BIGINT)
+  , m_rep(bigint) {
+  m_rep->add_ref();
+}
+
+Value::Value(File *file)
+  : m_kind(VALUE_FILE)
+  , m_rep(file) {
+  m_rep->add_ref();
+}
+
+Value::Value(MappedArray *arr)
+  : m_kind(VALUE_MAPPED_ARRAY)
+  , m_rep(arr) {
+  m_rep->add_ref();
+}
+
 Value::Value(const Value &other)
   : m_kind(VALUE_INT) {
   // Just use the assignment operator to copy the other Value's data
@@ -82,10 +178,115 @@ String *Value::get_string() const {
   return m_rep->as_string();
 }
 
+Bytes *Value::get_bytes() const {
+  assert(m_kind == VALUE_BYTES);
+  return m_rep->as_bytes();
+}
+
+Map *Value::get_map() const {
+  assert(m_kind == VALUE_MAP);
+  return m_rep->as_map();
+}
+
+Bitset *Value::get_bitset() const {
+  assert(m_kind == VALUE_BITSET);
+  return m_rep->as_bitset();
+}
+
+Deque *Value::get_deque() const {
+  assert(m_kind == VALUE_DEQUE);
+  return m_rep->as_deque();
+}
+
+PriorityQueue *Value::get_pqueue() const {
+  assert(m_kind == VALUE_PQUEUE);
+  return m_rep->as_pqueue();
+}
+
+Matrix *Value::get_matrix() const {
+  assert(m_kind == VALUE_MATRIX);
+  return m_rep->as_matrix();
+}
+
+Shape *Value::get_shape() const {
+  assert(m_kind == VALUE_SHAPE);
+  return m_rep->as_shape();
+}
+
+Record *Value::get_record() const {
+  assert(m_kind == VALUE_RECORD);
+  return m_rep->as_record();
+}
+
+RecordArray *Value::get_record_array() const {
+  assert(m_kind == VALUE_RECORD_ARRAY);
+  return m_rep->as_record_array();
+}
+
+BigInt *Value::get_bigint() const {
+  assert(m_kind == VALUE_BIGINT);
+  return m_rep->as_bigint();
+}
+
+double Value::to_double() const {
+  switch (m_kind) {
+  case VALUE_INT:
+    return double(m_atomic.ival);
+  case VALUE_DOUBLE:
+    return m_atomic.dval;
+  default:
+    return m_rep->as_bigint()->to_double();
+  }
+}
+
+int Value::compare_numeric(const Value &other) const {
+  if (m_kind == VALUE_INT && other.m_kind == VALUE_INT) {
+    return m_atomic.ival < other.m_atomic.ival ? -1 : m_atomic.ival > other.m_atomic.ival;
+  }
+  if (m_kind == VALUE_DOUBLE && other.m_kind == VALUE_DOUBLE) {
+    double l = m_atomic.dval, r = other.m_atomic.dval;
+    return l < r ? -1 : l > r;
+  }
+  if (m_kind == VALUE_DOUBLE) {
+    return -other.compare_numeric(*this);
+  }
+  if (other.m_kind == VALUE_DOUBLE) {
+    // compare an int or BigInt with a double exactly, rather than
+    // rounding the int to a double: compare with the double's integer
+    // part, then its fractional part
+    double d = other.m_atomic.dval;
+    if (std::isnan(d)) {
+      return 0;
+    }
+    if (std::isinf(d)) {
+      return d > 0 ? -1 : 1;
+    }
+    double int_part = std::trunc(d);
+    int cmp = BigInt::compare(*this, BigInt::from_double(int_part));
+    if (cmp != 0) {
+      return cmp;
+    }
+    return d > int_part ? -1 : d < int_part;
+  }
+  return BigInt::compare(*this, other);
+}
+
+File *Value::get_file() const {
+  assert(m_kind == VALUE_FILE);
+  return m_rep->as_file();
+}
+
+MappedArray *Value::get_mapped_array() const {
+  assert(m_kind == VALUE_MAPPED_ARRAY);
+  return m_rep->as_mapped_array();
+}
+
 std::string Value::as_str() const {
   switch (m_kind) {
   case VALUE_INT:
-    return cpputil::format("%d", m_atomic.ival);
+    return std::to_string(m_atomic.ival);
+  case VALUE_DOUBLE:
+    return double_as_str(m_atomic.dval);
   case VALUE_FUNCTION:
     return cpputil::format("<function %s>", m_rep->as_function()->get_name().c_str());
   case VALUE_INTRINSIC_FN:
@@ -94,6 +295,30 @@ std::string Value::as_str() const {
     return array_as_str();
   case VALUE_STRING:
     return m_rep->as_string()->get_actual_string();
+  case VALUE_BYTES:
+    return m_rep->as_bytes()->get_actual_string();
+  case VALUE_MAP:
+    return map_as_str();
+  case VALUE_BITSET:
+    return bitset_as_str();
+  case VALUE_DEQUE:
+    return deque_as_str();
+  case VALUE_PQUEUE:
+    return cpputil::format("<priority queue of %d>", m_rep->as_pqueue()->len());
+  case VALUE_MATRIX:
+    return matrix_as_str();
+  case VALUE_SHAPE:
+    return cpputil::format("<record %s>", m_rep->as_shape()->get_name().c_str());
+  case VALUE_RECORD:
+    return record_as_str();
+  case VALUE_RECORD_ARRAY:
+    return record_array_as_str();
+  case VALUE_BIGINT:
+    return m_rep->as_bigint()->as_str();
+  case VALUE_FILE:
+    return cpputil::format("<file %s>", m_rep->as_file()->get_path().c_str());
+  case VALUE_MAPPED_ARRAY:
+    return mapped_array_as_str();
   default:
     // this should not happen
     RuntimeError::raise("Unknown value type %d", int(m_kind));
@@ -112,6 +337,30 @@ void Value::detach() {
   }
 }
 
+std::string Value::double_as_str(double dval) {
+  char buf[DOUBLE_CHARS_MAX];
+  return std::string(buf, double_to_chars(buf, dval));
+}
+
+size_t Value::double_to_chars(char *buf, double dval) {
+  if (std::isnan(dval)) {
+    memcpy(buf, "nan", 3);
+    return 3;
+  }
+  if (std::isinf(dval)) {
+    memcpy(buf, dval < 0 ? "-inf" : "inf", dval < 0 ? 4 : 3);
+    return dval < 0 ? 4 : 3;
+  }
+  // shortest representation that reads back as the same double
+  char *end = std::to_chars(buf, buf + DOUBLE_CHARS_MAX - 2, dval).ptr;
+  // make sure it doesn't look like an int
+  if (std::find_if(buf, end, [](char c) { return c == '.' || c == 'e'; }) == end) {
+    *end++ = '.';
+    *end++ = '0';
+  }
+  return size_t(end - buf);
+}
+
 std::string Value::array_as_str() const {
   std::string result = "[";
   for (int i = 0; i < m_rep->as_array()->len(); i++) {
@@ -122,3 +371,100 @@ std::string Value::array_as_str() const {
   result += "]";
   return result;
 }
+
+
+std::string Value::map_as_str() const {
+  std::string result = "{";
+  bool first = true;
+  m_rep->as_map()->each_entry([&](const Value &key, const Value &value) {
+    if (!first)
+      result += ", ";
+    first = false;
+    result += key.as_str();
+    result += ": ";
+    result += value.as_str();
+  });
+  result += "}";
+  return result;
+}
+
+std::string Value::bitset_as_str() const {
+  std::string result = "{";
+  bool first = true;
+  m_rep->as_bitset()->each_member([&](int member) {
+    if (!first)
+      result += ", ";
+    first = false;
+    result += cpputil::format("%d", member);
+  });
+  result += "}";
+  return result;
+}
+
+std::string Value::deque_as_str() const {
+  std::string result = "[";
+  for (int i = 0; i < m_rep->as_deque()->len(); i++) {
+    if (i > 0)
+      result += ", ";
+    result += m_rep->as_deque()->get(i, Location()).as_str();
+  }
+  result += "]";
+  return result;
+}
+
+std::string Value::matrix_as_str() const {
+  Matrix *matrix = m_rep->as_matrix();
+  std::string result = "[";
+  for (int i = 0; i < matrix->rows(); i++) {
+    if (i > 0)
+      result += ", ";
+    result += "[";
+    for (int j = 0; j < matrix->cols(); j++) {
+      if (j > 0)
+        result += ", ";
+      result += cpputil::format("%d", matrix->get(i, j, Location()));
+    }
+    result += "]";
+  }
+  result += "]";
+  return result;
+}
+
+std::string Value::record_as_str() const {
+  Record *record = m_rep->as_record();
+  Shape *shape = record->get_shape();
+  std::string result = shape->get_name() + "{";
+  for (int i = 0; i < shape->get_num_fields(); i++) {
+    if (i > 0)
+      result += ", ";
+    result += shape->get_field_name(i);
+    result += ": ";
+    result += record->get(i).as_str();
+  }
+  result += "}";
+  return result;
+}
+
+std::string Value::record_array_as_str() const {
+  RecordArray *records = m_rep->as_record_array();
+  std::string result = "[";
+  for (int i = 0; i < records->len(); i++) {
+    if (i > 0)
+      result += ", ";
+    result += records->get(i, Location()).as_str();
+  }
+  result += "]";
+  return result;
+}
+
+std::string Value::mapped_array_as_str() const {
+  MappedArray *arr = m_rep->as_mapped_array();
+  std::string result = "[";
+  for (int i = 0; i < arr->len(); i++) {
+    if (i > 0)
+      result += ", ";
+    result += std::to_string(arr->get(i, Location()).get_ival());
+  }
+  result += "]";
+  return result;
+}
@@ -2,17 +2,31 @@
 #define VALUE_H
 
 #include <cassert>
+#include <cstdint>
 #include <string>
 
 class ValRep;
 class Function;
 class Array;
 class String;
+class Bytes;
+class Map;
+class Bitset;
+class Deque;
+class PriorityQueue;
+class Matrix;
+class Shape;
+class Record;
+class RecordArray;
+class BigInt;
+class File;
+class MappedArray;
 
 enum ValueKind {
   // "atomic" values
   VALUE_INT,
   VALUE_INTRINSIC_FN,
+  VALUE_DOUBLE,
   // could other kinds of atomic values here
 
   // dynamic values: these have an associated dynamically-allocated
@@ -20,7 +34,19 @@ enum ValueKind {
   VALUE_FUNCTION,
   // could add other kinds of dynamic values here
   VALUE_ARRAY,
-  VALUE_STRING
+  VALUE_STRING,
+  VALUE_BYTES,
+  VALUE_MAP,
+  VALUE_BITSET,
+  VALUE_DEQUE,
+  VALUE_PQUEUE,
+  VALUE_MATRIX,
+  VALUE_SHAPE,
+  VALUE_RECORD,
+  VALUE_RECORD_ARRAY,
+  VALUE_BIGINT,
+  VALUE_FILE,
+  VALUE_MAPPED_ARRAY
 };
 
 // Typedef of the signature of an intrinsic function.
@@ -34,7 +60,8 @@ typedef Value (*IntrinsicFn)(Value args[], unsigned num_args, const Location &lo
 // An "atomic" value that doesn't require a separate
 // (dynamically-allocated) representation
 union Atomic {
-  int ival;
+  int64_t ival;
+  double dval;
   IntrinsicFn intrinsic_fn;
 };
 
@@ -51,9 +78,23 @@ private:
 
 public:
   Value(int ival = 0);
+  Value(int64_t ival);
+  Value(double dval);
   Value(Function *fn);
   Value(Array *arr);
   Value(String *str);
+  Value(Bytes *bytes);
+  Value(Map *map);
+  Value(Bitset *bitset);
+  Value(Deque *deque);
+  Value(PriorityQueue *pqueue);
+  Value(Matrix *matrix);
+  Value(Shape *shape);
+  Value(Record *record);
+  Value(RecordArray *record_array);
+  Value(BigInt *bigint);
+  Value(File *file);
+  Value(MappedArray *arr);
   Value(IntrinsicFn intrinsic_fn);
   Value(const Value &other);
   ~Value();
@@ -66,11 +107,16 @@ public:
   // The caller should use get_kind() first to determine
   // what kind of data the Value is storing.
 
-  int get_ival() const {
+  int64_t get_ival() const {
     assert(m_kind == VALUE_INT);
     return m_atomic.ival;
   }
 
+  double get_dval() const {
+    assert(m_kind == VALUE_DOUBLE);
+    return m_atomic.dval;
+  }
+
   Function *get_function() const;
 
   IntrinsicFn get_intrinsic_fn() const {
@@ -82,10 +128,47 @@ public:
 
   String *get_string() const;
 
+  Bytes *get_bytes() const;
+
+  Map *get_map() const;
+
+  Bitset *get_bitset() const;
+
+  Deque *get_deque() const;
+
+  PriorityQueue *get_pqueue() const;
+
+  Matrix *get_matrix() const;
+
+  Shape *get_shape() const;
+
+  Record *get_record() const;
+
+  RecordArray *get_record_array() const;
+
+  BigInt *get_bigint() const;
+
+  File *get_file() const;
+
+  MappedArray *get_mapped_array() const;
+
   // convert to a string representation
   std::string as_str() const;
-
-  bool is_numeric() const { return m_kind == VALUE_INT; }
+  // Format a double as as_str does, into buf (which must have room
+  // for DOUBLE_CHARS_MAX chars), returning the length
+  static const size_t DOUBLE_CHARS_MAX = 32;
+  static size_t double_to_chars(char *buf, double dval);
+
+  // ints that don't fit in 64 bits are BigInts
+  bool is_integer() const { return m_kind == VALUE_INT || m_kind == VALUE_BIGINT; }
+  bool is_numeric() const { return is_integer() || m_kind == VALUE_DOUBLE; }
+
+  // value of a number as a double
+  double to_double() const;
+  // negative, zero or positive as this number is less than, equal to
+  // or greater than other, exactly even for an int and a double
+  // (NaN compares equal to everything)
+  int compare_numeric(const Value &other) const;
   bool is_dynamic() const { return m_kind >= VALUE_FUNCTION; }
   bool is_atomic() const  { return !is_dynamic(); }
 
@@ -94,7 +177,15 @@ private:
   void attach(ValRep *valrep);
   void detach();
 
+  static std::string double_as_str(double dval);
   std::string array_as_str() const;
+  std::string map_as_str() const;
+  std::string bitset_as_str() const;
+  std::string deque_as_str() const;
+  std::string matrix_as_str() const;
+  std::string record_as_str() const;
+  std::string record_array_as_str() const;
+  std::string mapped_array_as_str() const;
 };
 
 #endif // VALUE_H